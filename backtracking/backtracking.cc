@@ -1,5 +1,7 @@
 #include <array>
+#include <chrono>
 #include <iostream>
+#include <string>
 
 #include <cassert>
 
@@ -7,18 +9,20 @@
  * From Chapter 7 of Algorithm Design Manual
  */
 
-template <typename T, int K>
+/*
+ * the search calls the hooks of DERIVED statically, so they inline into
+ * the loop over the candidates: generate_candidates, process and
+ * terminates with the signatures of VirtualBacktracker below.
+ */
+template <typename DERIVED, typename T, int K>
 struct Backtracker {
   using Array = std::array<T, K>;
   using size_t = std::size_t;
 
-  virtual auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void = 0;
-  virtual auto process(const Array & input, const size_t index) -> void = 0;
-  virtual auto terminates(const Array & input, const size_t index) -> bool = 0;
-
   void operator () (Array & input, const int index = 0) {
-    if (terminates(input, index)) {
-      process(input, index);
+    DERIVED & self = static_cast<DERIVED &>(*this);
+    if (self.terminates(input, index)) {
+      self.process(input, index);
     }
 
     if (finished_) {
@@ -28,7 +32,7 @@ struct Backtracker {
     if (K >= index) {
       Array candidates;
       size_t number_of_candidates = 0;
-      generate_candidates(input, index, candidates, number_of_candidates);
+      self.generate_candidates(input, index, candidates, number_of_candidates);
       if (0 < number_of_candidates) {
         for (size_t k = 0; k < number_of_candidates; ++k) {
           // open for some hook here
@@ -57,14 +61,29 @@ private:
   bool finished_ = false;
 };
 
+/*
+ * the hooks behind virtual calls, for problems only known at runtime
+ */
+template <typename T, int K>
+struct VirtualBacktracker : Backtracker<VirtualBacktracker<T, K>, T, K> {
+  using Array = std::array<T, K>;
+  using size_t = std::size_t;
+
+  virtual ~VirtualBacktracker() = default;
+
+  virtual auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void = 0;
+  virtual auto process(const Array & input, const size_t index) -> void = 0;
+  virtual auto terminates(const Array & input, const size_t index) -> bool = 0;
+};
+
 /*
  * Generates a factorial : K!
  */
 template<int K, int START = 1>
-struct NumericPermutations : Backtracker<int, K> {
-  using Array = typename Backtracker<int, K>::Array;
+struct NumericPermutations : Backtracker<NumericPermutations<K, START>, int, K> {
+  using Array = typename Backtracker<NumericPermutations<K, START>, int, K>::Array;
 
-  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void override {
+  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void {
     assert(0 == number_of_candidates);
     if (K == input_size) { return; }
     Array possible_candidates{ 0, };
@@ -79,7 +98,7 @@ struct NumericPermutations : Backtracker<int, K> {
     assert(K >= number_of_candidates);
   }
 
-  auto process(const Array & input, const std::size_t index) -> void override {
+  auto process(const Array & input, const std::size_t index) -> void {
     std::cout << "{";
     for (const auto & item : input) {
       std::cout << " " << item;
@@ -87,7 +106,7 @@ struct NumericPermutations : Backtracker<int, K> {
     std::cout << " }" << std::endl;
   }
 
-  auto terminates(const Array & input, const std::size_t index) -> bool override {
+  auto terminates(const Array & input, const std::size_t index) -> bool {
     return K == index;
   }
 };
@@ -96,10 +115,10 @@ struct NumericPermutations : Backtracker<int, K> {
  * Subsets
  */
 template<int K, int START = 1>
-struct NumericSubsets : Backtracker<int, K> {
-  using Array = typename Backtracker<int, K>::Array;
+struct NumericSubsets : Backtracker<NumericSubsets<K, START>, int, K> {
+  using Array = typename Backtracker<NumericSubsets<K, START>, int, K>::Array;
 
-  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void override {
+  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void {
     assert(0 == number_of_candidates);
     if (K > input_size) {
       candidates = { 1, 0, };
@@ -107,7 +126,7 @@ struct NumericSubsets : Backtracker<int, K> {
     }
   }
 
-  auto process(const Array & input, const std::size_t index) -> void override {
+  auto process(const Array & input, const std::size_t index) -> void {
     std::cout << "(";
     for (int i = 0; K > i; ++i) {
       if (0 < input[i]) {
@@ -117,12 +136,86 @@ struct NumericSubsets : Backtracker<int, K> {
     std::cout << " )" << std::endl;
   }
 
-  auto terminates(const Array & input, const std::size_t index) -> bool override {
+  auto terminates(const Array & input, const std::size_t index) -> bool {
     return K == index;
   }
 };
 
-int main() {
+/*
+ * the candidates and leaves of PROBLEM, counting the nodes instead of
+ * processing them, through static hooks or through virtual ones.
+ */
+template<typename PROBLEM, int K>
+struct StaticCount : Backtracker<StaticCount<PROBLEM, K>, int, K> {
+  using Array = typename Backtracker<StaticCount<PROBLEM, K>, int, K>::Array;
+  PROBLEM problem;
+  std::size_t nodes = 0, leaves = 0;
+
+  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void {
+    problem.generate_candidates(input, input_size, candidates, number_of_candidates);
+  }
+
+  auto process(const Array & input, const std::size_t index) -> void {
+    ++leaves;
+  }
+
+  auto terminates(const Array & input, const std::size_t index) -> bool {
+    ++nodes;
+    return problem.terminates(input, index);
+  }
+};
+
+template<typename PROBLEM, int K>
+struct VirtualCount : VirtualBacktracker<int, K> {
+  using Array = typename VirtualBacktracker<int, K>::Array;
+  PROBLEM problem;
+  std::size_t nodes = 0, leaves = 0;
+
+  auto generate_candidates(const Array & input, const size_t input_size, Array & candidates, size_t & number_of_candidates) -> void override {
+    problem.generate_candidates(input, input_size, candidates, number_of_candidates);
+  }
+
+  auto process(const Array & input, const std::size_t index) -> void override {
+    ++leaves;
+  }
+
+  auto terminates(const Array & input, const std::size_t index) -> bool override {
+    ++nodes;
+    return problem.terminates(input, index);
+  }
+};
+
+template<typename COUNT>
+void count(const char * name, const std::size_t rounds) {
+  COUNT counter;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; rounds > round; ++round) {
+    counter();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "  " << name << ": " << counter.nodes << " nodes, " << counter.leaves << " leaves, "
+    << seconds << "s, " << counter.nodes / seconds << " nodes/s" << std::endl;
+}
+
+/*
+ * the permutations of 12 once and the subsets of 12 rounds times, with
+ * static and with virtual hooks.
+ */
+void benchmark(const std::size_t rounds) {
+  std::cout << "Numeric Permutations, K = 12" << std::endl;
+  count<StaticCount<NumericPermutations<12>, 12>>("static", 1);
+  count<VirtualCount<NumericPermutations<12>, 12>>("virtual", 1);
+  std::cout << "Numeric Subsets, K = 12, " << rounds << " rounds" << std::endl;
+  count<StaticCount<NumericSubsets<12>, 12>>("static", rounds);
+  count<VirtualCount<NumericSubsets<12>, 12>>("virtual", rounds);
+}
+
+int main(int argc, char * * argv) {
+  if (1 < argc && std::string("benchmark") == argv[1]) {
+    benchmark(2 < argc ? std::stoul(argv[2]) : 10000);
+    return 0;
+  }
+
   std::cout << "Numeric Permutations 14-16" << std::endl;
   NumericPermutations<3, 14> permutations;
   permutations();
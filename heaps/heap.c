@@ -1,51 +1,182 @@
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+/*
+ * binary max-heap of opaque pointers stored in an implicit array,
+ * the children of index i live at 2 * i + 1 and 2 * i + 2.
+ *
+ * every entry carries a fixed-width sort key next to its pointer, so
+ * most comparisons never touch the element. key must be monotonic with
+ * greater_than: key(a) > key(b) implies greater_than(a, b). greater_than
+ * only runs when both keys are equal.
+ */
+struct heap_entry {
+  uint64_t key;
+  void * element;
+};
 
 struct heap {
-  void * * heap;
-  int size;
+  struct heap_entry * heap;
+  int size; /* capacity */
+  int count; /* number of elements */
+  uint64_t (*key)(void *); /* NULL means every comparison calls greater_than */
 };
 
-void heap_create(struct heap * * h, int size) {
+static inline struct heap_entry heap_entry(struct heap * h, void * element) {
+  struct heap_entry entry = {NULL != h->key ? h->key(element) : 0, element};
+  return entry;
+}
+
+static inline int heap_entry_greater_than(const struct heap_entry * a, const struct heap_entry * b, int (*greater_than)(void *, void *)) {
+  if (a->key != b->key) {
+    return a->key > b->key;
+  }
+  return greater_than(a->element, b->element);
+}
+
+void heap_create(struct heap * * h, int size, uint64_t (*key)(void *)) {
   assert(0 < size);
   int real_size = 1;
   while (0 < real_size && real_size < size) {
     real_size <<= 1;
   }
   *h = malloc(sizeof(struct heap));
-  (*h)->heap = malloc(sizeof((*h)->heap) * real_size);
-  memset((*h)->heap, 0, sizeof((*h)->heap) * real_size);
+  (*h)->heap = malloc(sizeof(*(*h)->heap) * real_size);
+  memset((*h)->heap, 0, sizeof(*(*h)->heap) * real_size);
   (*h)->size = real_size;
+  (*h)->count = 0;
+  (*h)->key = key;
+}
+
+static void heap_sift_up(struct heap * h, int i, int (*greater_than)(void *, void *)) {
+  const struct heap_entry entry = h->heap[i];
+  while (0 < i) {
+    const int parent = (i - 1) / 2;
+    if ( ! heap_entry_greater_than(&entry, h->heap + parent, greater_than)) {
+      break;
+    }
+    h->heap[i] = h->heap[parent];
+    i = parent;
+  }
+  h->heap[i] = entry;
+}
+
+static void heap_sift_down(struct heap * h, int i, int (*greater_than)(void *, void *)) {
+  const struct heap_entry entry = h->heap[i];
+  const int half = h->count / 2;
+  while (half > i) {
+    int child = 2 * i + 1;
+    if (h->count > child + 1 && heap_entry_greater_than(h->heap + child + 1, h->heap + child, greater_than)) {
+      ++child;
+    }
+    if ( ! heap_entry_greater_than(h->heap + child, &entry, greater_than)) {
+      break;
+    }
+    h->heap[i] = h->heap[child];
+    i = child;
+  }
+  h->heap[i] = entry;
+}
+
+/*
+ * copies the elements along with their keys and heapifies them bottom-up
+ * (Floyd), which is O(n) as opposed to O(n log n) for n inserts. entries
+ * are wider than the pointers in elements, so elements is left as it is
+ * instead of being heapified in place.
+ */
+void heap_build(struct heap * * h, void * * elements, int count, uint64_t (*key)(void *), int (*greater_than)(void *, void *)) {
+  assert(NULL != elements);
+  assert(0 <= count);
+  assert(NULL != greater_than);
+  heap_create(h, 0 < count ? count : 1, key);
+  for (int i = 0; count > i; ++i) {
+    (*h)->heap[i] = heap_entry(*h, elements[i]);
+  }
+  (*h)->count = count;
+  for (int i = count / 2 - 1; 0 <= i; --i) {
+    heap_sift_down(*h, i, greater_than);
+  }
 }
 
 void heap_insert(struct heap * h, void * element, int (*greater_than)(void *, void *)) {
   assert(NULL != h);
   assert(NULL != element);
   assert(NULL != greater_than);
-  int i = 1;
-  while (NULL != h->heap[i - 1]) {
-    if (greater_than(element, h->heap[i - 1])) {
-      i = 2 * i + 1;
-    } else {
-      i *= 2;
-    }
-  }
-  if (h->size >= i) {
-    h->heap[i - 1] = element;
+  if (h->size > h->count) {
+    h->heap[h->count] = heap_entry(h, element);
+    heap_sift_up(h, h->count++, greater_than);
   } else {
     fprintf(stderr, "not enough space\n");
   }
 }
 
+/*
+ * appends all elements and then only re-heapifies the ancestors of the
+ * appended range, level by level, bottom-up. that costs O(count + log n)
+ * sift-downs instead of count sift-ups.
+ */
+void heap_push_many(struct heap * h, void * * elements, int count, int (*greater_than)(void *, void *)) {
+  assert(NULL != h);
+  assert(NULL != elements);
+  assert(0 <= count);
+  assert(NULL != greater_than);
+  if (h->size - h->count < count) {
+    fprintf(stderr, "not enough space\n");
+    return;
+  }
+  if (0 == count) {
+    return;
+  }
+  for (int i = 0; count > i; ++i) {
+    h->heap[h->count + i] = heap_entry(h, elements[i]);
+  }
+  int low = h->count, high = h->count + count - 1;
+  h->count += count;
+  while (0 < high) {
+    low = (low - 1) / 2;
+    high = (high - 1) / 2;
+    for (int i = high; low <= i; --i) {
+      heap_sift_down(h, i, greater_than);
+    }
+  }
+}
+
+void * heap_pop(struct heap * h, int (*greater_than)(void *, void *)) {
+  assert(NULL != h);
+  assert(NULL != greater_than);
+  if (0 == h->count) {
+    return NULL;
+  }
+  void * result = h->heap[0].element;
+  h->heap[0] = h->heap[--h->count];
+  if (0 < h->count) {
+    heap_sift_down(h, 0, greater_than);
+  }
+  return result;
+}
+
+/*
+ * drains the heap into output in ascending order, output must hold
+ * at least h->count elements. the heap is left empty.
+ */
+void heap_sort(struct heap * h, void * * output, int (*greater_than)(void *, void *)) {
+  assert(NULL != h);
+  assert(NULL != output);
+  assert(NULL != greater_than);
+  for (int i = h->count - 1; 0 <= i; --i) {
+    output[i] = heap_pop(h, greater_than);
+  }
+}
+
 void heap_traverse(struct heap * h, void (*print)(void *)) {
   assert(NULL != h);
   assert(NULL != print);
-  for (int i = 0; h->size > i; ++i) {
-    if (NULL != h->heap[i]) {
-      print(h->heap[i]);
-    }
+  for (int i = 0; h->count > i; ++i) {
+    print(h->heap[i].element);
   }
 }
 
@@ -62,6 +193,21 @@ int record_greater_than(void * a, void * b) {
   return 0 < strcmp(((struct record *)a)->name, ((struct record *)b)->name);
 }
 
+/* first 8 bytes of the name, big-endian, so it orders like strcmp */
+uint64_t record_key(void * p) {
+  assert(NULL != p);
+  const unsigned char * name = (const unsigned char *)((struct record *)p)->name;
+  uint64_t key = 0;
+  int i = 0;
+  for (; 8 > i && '\0' != name[i]; ++i) {
+    key = (key << 8) | name[i];
+  }
+  for (; 8 > i; ++i) {
+    key <<= 8;
+  }
+  return key;
+}
+
 void record_print(void * p) {
   assert(NULL != p);
   struct record * r = (struct record *)(p);
@@ -70,13 +216,109 @@ void record_print(void * p) {
   printf("name: %s, address: %s\n", r->name, r->address);
 }
 
+/* BENCHMARK */
+
+static double seconds(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static struct record * records_create(int count) {
+  struct record * records = malloc(sizeof(struct record) * count);
+  char * names = malloc(16 * (size_t)count);
+  for (int i = 0; count > i; ++i) {
+    char * name = names + 16 * (size_t)i;
+    for (int j = 0; 15 > j; ++j) {
+      name[j] = 'a' + rand() % 26;
+    }
+    name[15] = '\0';
+    records[i].name = name;
+    records[i].address = "";
+  }
+  return records;
+}
+
+static void check_sorted(void * * output, int count) {
+  for (int i = 1; count > i; ++i) {
+    assert( ! record_greater_than(output[i - 1], output[i]));
+  }
+}
+
+int benchmark(int count, uint64_t (*key)(void *)) {
+  const int batch = 1 << 16;
+  srand(time(NULL));
+  struct record * records = records_create(count);
+  void * * elements = malloc(sizeof(void *) * count);
+  void * * output = malloc(sizeof(void *) * count);
+  double start;
+
+  printf("%d records, %s keys\n", count, NULL != key ? "prefix" : "pointer");
+
+  {
+    struct heap * h = NULL;
+    heap_create(&h, count, key);
+    start = seconds();
+    for (int i = 0; count > i; ++i) {
+      heap_insert(h, records + i, record_greater_than);
+    }
+    printf("heap_insert x %d: %.3fs\n", count, seconds() - start);
+    start = seconds();
+    heap_sort(h, output, record_greater_than);
+    printf("heap_sort: %.3fs\n", seconds() - start);
+    check_sorted(output, count);
+    free(h->heap);
+    free(h);
+  }
+
+  {
+    struct heap * h = NULL;
+    heap_create(&h, count, key);
+    for (int i = 0; count > i; ++i) {
+      elements[i] = records + i;
+    }
+    start = seconds();
+    for (int i = 0; count > i; i += batch) {
+      heap_push_many(h, elements + i, count - i < batch ? count - i : batch, record_greater_than);
+    }
+    printf("heap_push_many x %d: %.3fs\n", batch, seconds() - start);
+    heap_sort(h, output, record_greater_than);
+    check_sorted(output, count);
+    free(h->heap);
+    free(h);
+  }
+
+  {
+    struct heap * h = NULL;
+    start = seconds();
+    heap_build(&h, elements, count, key, record_greater_than);
+    printf("heap_build: %.3fs\n", seconds() - start);
+    heap_sort(h, output, record_greater_than);
+    check_sorted(output, count);
+    free(h->heap);
+    free(h);
+  }
+
+  free(output);
+  free(elements);
+  free((void *)records[0].name);
+  free(records);
+  return 0;
+}
+
 /* IMPL */
 
 int main(int argc, char ** argv) {
   int result = 0;
 
+  if (2 < argc && 0 == strcmp("benchmark", argv[1])) {
+    /* "pointer" disables the inlined keys, for before/after comparison */
+    const int pointer = 3 < argc && 0 == strcmp("pointer", argv[3]);
+    return benchmark(atoi(argv[2]), pointer ? NULL : record_key);
+  }
+
   struct heap * my_heap = NULL;
-  heap_create(&my_heap, /* make sure it is always a power of 2 */ 16);
+  heap_create(&my_heap, /* make sure it is always a power of 2 */ 16, record_key);
 
   {
     struct record * my_record = malloc(sizeof(struct record));
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "branch-and-bound.h"
+#include "knapsack.h"
+
+/*
+ * Knapsack Batch
+ * --------------
+ * solves a stream of instances on threads workers. the calling thread
+ * reads instances and queues them CHUNK at a time while the stream has
+ * more buffered, and at once when the next read would block, so whatever
+ * has been read is solved while the producer is slow. it waits once
+ * QUEUE instances are ahead of the answers. workers sleep on a condition
+ * variable while there is nothing to do. a worker that finishes the
+ * oldest open instance writes every answer that is ready from there on,
+ * in input order, and flushes once the queue runs dry.
+ *
+ * every worker keeps its own solvers, so the DP rows and bitsets are
+ * allocated once and reused by every instance; instances of more than
+ * DYNAMIC cells go to branch and bound instead.
+ *
+ * LINES input is one instance per line, the capacity followed by the cost
+ * and value of every item, all in decimal. BINARY input is, per instance,
+ * uint32 capacity, uint32 count, then count pairs of uint32 cost and value,
+ * in the byte order of the machine. either way every answer is one line,
+ * the best value, the number of items taken and their costs and values,
+ * most expensive first. malformed input throws std::runtime_error, after
+ * the instances before it are answered.
+ */
+class KnapsackBatch {
+public:
+  using size = std::size_t;
+  enum class Format { LINES, BINARY };
+  static constexpr size QUEUE = 1024;
+  static constexpr size CHUNK = 64;
+  static constexpr size PAIRS = 4096;
+  static constexpr size DYNAMIC = size{1} << 26;
+
+  explicit KnapsackBatch(const size threads = 1) : threads_(std::max<size>(1, threads)) { }
+
+  /* the number of instances solved */
+  size operator()(std::istream & in, std::ostream & out, const Format format) {
+    std::mutex mutex;
+    std::condition_variable ready, room;
+    std::deque<Job> jobs;
+    std::deque<Answer> answers;
+    size written = 0;
+    bool done = false;
+    /* a tied in, like std::cin, would flush out from the reading thread */
+    std::ostream * const tied = in.tie(nullptr);
+
+    const auto work = [&]() {
+      DynamicKnapsack dynamic;
+      BranchAndBoundKnapsack branch_and_bound;
+      std::string output;
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        ready.wait(lock, [&]() { return done || ! jobs.empty(); });
+        if (jobs.empty()) {
+          return;
+        }
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        const bool small = DYNAMIC / (job.items.size() + 1) > static_cast<size>(job.capacity);
+        Items result = small ? dynamic(std::move(job.items), job.capacity)
+          : branch_and_bound(std::move(job.items), job.capacity);
+        lock.lock();
+
+        Answer & answer = answers[job.sequence - written];
+        answer.result = std::move(result);
+        answer.ready = true;
+        output.clear();
+        for (; ! answers.empty() && answers.front().ready; ++written) {
+          write(answers.front().result, output);
+          answers.pop_front();
+        }
+        if ( ! output.empty()) {
+          out.write(output.data(), output.size());
+          if (jobs.empty()) {
+            out.flush();
+          }
+          room.notify_one();
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size t = 0; threads_ > t; ++t) {
+      threads.emplace_back(work);
+    }
+    const auto stop = [&]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+      }
+      ready.notify_all();
+      for (auto & thread : threads) {
+        thread.join();
+      }
+      out.flush();
+      in.tie(tied);
+    };
+
+    size count = 0;
+    std::vector<Job> read_ahead;
+    const auto dispatch = [&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      room.wait(lock, [&]() { return QUEUE > answers.size(); });
+      for (auto & job : read_ahead) {
+        jobs.push_back(std::move(job));
+        answers.emplace_back();
+      }
+      lock.unlock();
+      ready.notify_all();
+      read_ahead.clear();
+    };
+    try {
+      for (Job job; read(in, format, job); ++count) {
+        job.sequence = count;
+        read_ahead.push_back(std::move(job));
+        job.items.clear();
+        if (CHUNK == read_ahead.size() || 0 >= in.rdbuf()->in_avail()) {
+          dispatch();
+        }
+      }
+      dispatch();
+    } catch (...) {
+      dispatch();
+      stop();
+      throw;
+    }
+    stop();
+    return count;
+  }
+
+private:
+  struct Job {
+    size sequence;
+    int capacity;
+    Items items;
+  };
+
+  struct Answer {
+    bool ready = false;
+    Items result;
+  };
+
+  /* the next instance into job, false at the end of in */
+  bool read(std::istream & in, const Format format, Job & job) {
+    if (Format::BINARY == format) {
+      std::uint32_t header[2];
+      if ( ! in.read(reinterpret_cast<char *>(header), sizeof(header))) {
+        if (0 != in.gcount()) {
+          throw std::runtime_error("truncated instance header");
+        }
+        return false;
+      }
+      if (INT_MAX < header[0]) {
+        throw std::runtime_error("capacity over INT_MAX");
+      }
+      job.capacity = header[0];
+      /* PAIRS at a time, so a bogus count runs out of input before it runs out of memory */
+      for (size left = header[1]; 0 < left;) {
+        const size pairs = std::min(left, PAIRS);
+        pairs_.resize(2 * pairs);
+        const std::streamsize bytes = pairs_.size() * sizeof(std::uint32_t);
+        if ( ! in.read(reinterpret_cast<char *>(pairs_.data()), bytes)) {
+          throw std::runtime_error("truncated instance items");
+        }
+        for (size i = 0; pairs > i; ++i) {
+          job.items.push_back(Item{pairs_[2 * i], pairs_[2 * i + 1]});
+        }
+        left -= pairs;
+      }
+      return true;
+    }
+    while (std::getline(in, line_)) {
+      const char * first = line_.data(), * const last = line_.data() + line_.size();
+      size capacity;
+      if ( ! number(first, last, capacity)) {
+        continue;
+      }
+      if (INT_MAX < capacity) {
+        throw std::runtime_error("capacity over INT_MAX");
+      }
+      job.capacity = capacity;
+      for (Item item; number(first, last, item.cost);) {
+        if ( ! number(first, last, item.value)) {
+          throw std::runtime_error("item without a value: " + line_);
+        }
+        job.items.push_back(item);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  /* the next decimal number in [first, last), false if there is none */
+  static bool number(const char * & first, const char * const last, size & result) {
+    while (last != first && (' ' == *first || '\t' == *first || '\r' == *first)) {
+      ++first;
+    }
+    if (last == first) {
+      return false;
+    }
+    const auto [end, error] = std::from_chars(first, last, result);
+    if (std::errc() != error) {
+      throw std::runtime_error("not a number: " + std::string(first, last));
+    }
+    first = end;
+    return true;
+  }
+
+  static void write(const Items & result, std::string & output) {
+    size value = 0;
+    for (const auto & item : result) {
+      value += item.value;
+    }
+    output += std::to_string(value);
+    output += ' ';
+    output += std::to_string(result.size());
+    for (const auto & item : result) {
+      output += ' ';
+      output += std::to_string(item.cost);
+      output += ' ';
+      output += std::to_string(item.value);
+    }
+    output += '\n';
+  }
+
+  size threads_;
+  std::vector<std::uint32_t> pairs_;
+  std::string line_;
+};
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "../mergesort/task-pool.h"
+#include "../priority-heaps/priority-heap.h"
+#include "knapsack.h"
+
+/*
+ * Branch and Bound Knapsack
+ * -------------------------
+ * 0/1 knapsack without a table, for capacities no DP row can hold. items
+ * are sorted by value per cost, so below a node taking the next items
+ * while they fit plus the fitting fraction of the first that does not is
+ * an upper bound on any choice (the LP relaxation). with prefix sums of
+ * costs and values that bound is one binary search away. nodes whose
+ * bound cannot beat the best choice found so far are not searched.
+ *
+ * DEPTH_FIRST takes items greedily and backtracks over a stack of the
+ * taken ones (Horowitz-Sahni), in O(n) memory. BEST_FIRST expands the
+ * open node of the greatest bound from a heap and stops once that bound
+ * cannot improve, it visits fewer nodes but keeps all open ones around.
+ *
+ * on a TaskPool the first levels are expanded into PARTS subtrees per
+ * thread, searched depth first in parallel against a shared atomic best
+ * value, seeded with the greedy choice.
+ *
+ * items are returned from the most expensive to the cheapest, the sum of
+ * all values must stay below 2^64.
+ */
+class BranchAndBoundKnapsack {
+public:
+  using size = std::size_t;
+  using Value = std::uint64_t;
+  enum class Order { DEPTH_FIRST, BEST_FIRST };
+  static constexpr size PARTS = 4;
+
+  explicit BranchAndBoundKnapsack(const Order order = Order::DEPTH_FIRST) : order_(order) { }
+
+  Items operator()(Items input, const int max_cost) {
+    Items result;
+    if (prepare(input, max_cost, result)) {
+      Search search;
+      if (Order::BEST_FIRST == order_) {
+        best_first(search);
+      } else {
+        depth_first(0, capacity_, 0, search, nullptr);
+      }
+      collect(search, result);
+    }
+    return result;
+  }
+
+  Items operator()(TaskPool & pool, Items input, const int max_cost) {
+    Items result;
+    if ( ! prepare(input, max_cost, result)) {
+      return result;
+    }
+    Search greedy;
+    Value value = 0;
+    for (size i = 0, room = capacity_; n() > i; ++i) {
+      if (items_[i].cost <= room) {
+        greedy.best.push_back(i);
+        room -= items_[i].cost;
+        value += items_[i].value;
+      }
+    }
+    greedy.value = value;
+    if (1 == pool.threads()) {
+      depth_first(0, capacity_, 0, greedy, nullptr);
+      collect(greedy, result);
+      return result;
+    }
+
+    std::vector<Part> parts = split(PARTS * pool.threads());
+    std::vector<Search> searches(parts.size());
+    std::atomic<Value> shared{value};
+    TaskPool::Group group;
+    for (size p = 0; parts.size() > p; ++p) {
+      pool.spawn(group, [&, p]() {
+        const Part & part = parts[p];
+        searches[p].stack = part.taken;
+        depth_first(part.index, part.room, part.value, searches[p], &shared);
+      });
+    }
+    pool.wait(group);
+    const Search * best = &greedy;
+    for (const auto & search : searches) {
+      if (best->value < search.value) {
+        best = &search;
+      }
+    }
+    collect(*best, result);
+    return result;
+  }
+
+private:
+  /* the taken items on the way down and the best choice a search found */
+  struct Search {
+    std::vector<size> stack, best;
+    Value value = 0;
+  };
+
+  /* a subtree: the items before index are decided, the taken ones in taken */
+  struct Part {
+    size index, room;
+    Value value;
+    std::vector<size> taken;
+  };
+
+  /* an open node for BEST_FIRST, the heap pops the greatest bound first */
+  struct Node {
+    Value bound, value;
+    size index, room, trail;
+    bool operator > (const Node & other) const { return bound < other.bound; }
+  };
+
+  static constexpr size NONE = ~size{0};
+
+  size n() const { return items_.size(); }
+
+  /* free items go straight into result, the others by density into items_, false if none is left */
+  bool prepare(const Items & input, const int max_cost, Items & result) {
+    if (0 > max_cost) {
+      return false;
+    }
+    capacity_ = max_cost;
+    items_.clear();
+    for (const auto & item : input) {
+      if (0 == item.cost) {
+        result.push_back(item);
+      } else if (capacity_ >= item.cost) {
+        items_.push_back(item);
+      }
+    }
+    std::sort(items_.begin(), items_.end(), [](const Item & a, const Item & b) {
+      return static_cast<unsigned __int128>(a.value) * b.cost > static_cast<unsigned __int128>(b.value) * a.cost;
+    });
+    costs_.assign(n() + 1, 0);
+    values_.assign(n() + 1, 0);
+    cheapest_.assign(n() + 1, ~size{0});
+    for (size i = 0; n() > i; ++i) {
+      costs_[i + 1] = costs_[i] + items_[i].cost;
+      values_[i + 1] = values_[i] + items_[i].value;
+    }
+    for (size i = n(); 0 < i--;) {
+      cheapest_[i] = std::min(cheapest_[i + 1], items_[i].cost);
+    }
+    return 0 < n();
+  }
+
+  /* the first item from index on that fits into room, n if none */
+  size next(size index, const size room) const {
+    if (cheapest_[index] > room) {
+      return n();
+    }
+    while (items_[index].cost > room) {
+      ++index;
+    }
+    return index;
+  }
+
+  /* the LP bound below a node, items index ... fit - 1 fit whole */
+  Value bound(const size index, const size room, const Value value, size & fit) const {
+    fit = std::upper_bound(costs_.begin() + index, costs_.end(), costs_[index] + room) - costs_.begin() - 1;
+    Value result = value + values_[fit] - values_[index];
+    if (n() > fit) {
+      const size left = costs_[index] + room - costs_[fit];
+      result += static_cast<unsigned __int128>(items_[fit].value) * left / items_[fit].cost;
+    }
+    return result;
+  }
+
+  /* searches below a node, backtracking no further than the items already on the stack */
+  void depth_first(size index, size room, Value value, Search & search, std::atomic<Value> * const shared) {
+    const size floor = search.stack.size();
+    while (true) {
+      const Value best = nullptr == shared ? search.value
+        : std::max(search.value, shared->load(std::memory_order_relaxed));
+      size fit;
+      if (bound(index, room, value, fit) > best) {
+        for (size i = index; fit > i; ++i) {
+          search.stack.push_back(i);
+        }
+        room -= costs_[fit] - costs_[index];
+        value += values_[fit] - values_[index];
+        index = n() > fit ? next(fit + 1, room) : n();
+        if (n() > index) {
+          continue;
+        }
+        if (search.value < value) {
+          search.value = value;
+          search.best = search.stack;
+          if (nullptr != shared) {
+            Value expected = shared->load(std::memory_order_relaxed);
+            while (expected < value && ! shared->compare_exchange_weak(expected, value, std::memory_order_relaxed)) { }
+          }
+        }
+      }
+      if (floor == search.stack.size()) {
+        return;
+      }
+      const size last = search.stack.back();
+      search.stack.pop_back();
+      room += items_[last].cost;
+      value -= items_[last].value;
+      index = next(last + 1, room);
+    }
+  }
+
+  void best_first(Search & search) {
+    trail_.clear();
+    PriorityHeap<Node, 4> open;
+    size best = NONE, fit;
+    const auto push = [&](const size index, const size room, const Value value, const size trail) {
+      if (search.value < value) {
+        search.value = value;
+        best = trail;
+      }
+      const Value limit = bound(index, room, value, fit);
+      if (n() > index && limit > search.value) {
+        open.push(Node{limit, value, index, room, trail});
+      }
+    };
+    push(next(0, capacity_), capacity_, 0, NONE);
+    while ( ! open.empty() && open.top().bound > search.value) {
+      const Node node = open.pop();
+      const Item & item = items_[node.index];
+      trail_.emplace_back(node.trail, node.index);
+      push(next(node.index + 1, node.room - item.cost), node.room - item.cost, node.value + item.value, trail_.size() - 1);
+      push(next(node.index + 1, node.room), node.room, node.value, node.trail);
+    }
+    for (; NONE != best; best = trail_[best].first) {
+      search.best.push_back(trail_[best].second);
+    }
+  }
+
+  /* every node reached breadth first once parts are open, or none is left */
+  std::vector<Part> split(const size parts) const {
+    std::vector<Part> open{Part{next(0, capacity_), capacity_, 0, {}}}, closed;
+    while ( ! open.empty() && parts > open.size() + closed.size()) {
+      std::vector<Part> children;
+      for (auto & part : open) {
+        if (n() == part.index) {
+          closed.push_back(std::move(part));
+          continue;
+        }
+        const Item & item = items_[part.index];
+        Part taken{next(part.index + 1, part.room - item.cost), part.room - item.cost, part.value + item.value, part.taken};
+        taken.taken.push_back(part.index);
+        children.push_back(std::move(taken));
+        children.push_back(Part{next(part.index + 1, part.room), part.room, part.value, std::move(part.taken)});
+      }
+      open.swap(children);
+    }
+    open.insert(open.end(), closed.begin(), closed.end());
+    return open;
+  }
+
+  void collect(const Search & search, Items & result) const {
+    for (const size i : search.best) {
+      result.push_back(items_[i]);
+    }
+    std::sort(result.begin(), result.end(), [](const Item & a, const Item & b) { return b < a; });
+  }
+
+  Order order_;
+  size capacity_ = 0;
+  Items items_;
+  std::vector<size> costs_, cheapest_;
+  std::vector<Value> values_;
+  std::vector<std::pair<size, size>> trail_;
+};
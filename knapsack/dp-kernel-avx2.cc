@@ -0,0 +1,61 @@
+/* built with -mavx2 */
+
+#include <immintrin.h>
+
+#include "dp-kernel.h"
+
+namespace simd {
+namespace avx2 {
+namespace {
+
+template<bool RECORD>
+void step(std::uint64_t * const best, const std::uint64_t * const source, const std::size_t w,
+    const std::size_t cost, const std::uint64_t value, std::uint64_t * const taken) {
+  const std::uint64_t take = source[w - cost] + value;
+  const bool better = source[w] < take;
+  best[w] = better ? take : source[w];
+  if (RECORD) {
+    taken[w / 64] |= std::uint64_t{better} << (w % 64);
+  }
+}
+
+/*
+ * 4 values at a time from the highest aligned block down, the odd ones
+ * at both ends one by one. a block loads its sources before storing, and
+ * those lie below every block stored so far, so best may be source.
+ */
+template<bool RECORD>
+void relax(std::uint64_t * const best, const std::uint64_t * const source, const std::size_t from, std::size_t w,
+    const std::size_t cost, const std::uint64_t value, std::uint64_t * const taken) {
+  for (; from < w && 0 != w % 4; --w) {
+    step<RECORD>(best, source, w - 1, cost, value, taken);
+  }
+  const __m256i values = _mm256_set1_epi64x(value);
+  for (; from + 4 <= w; w -= 4) {
+    const std::size_t i = w - 4;
+    const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+    const __m256i take = _mm256_add_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i - cost)), values);
+    const __m256i better = _mm256_cmpgt_epi64(take, current);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(best + i), _mm256_blendv_epi8(current, take, better));
+    if (RECORD) {
+      taken[i / 64] |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(better))) << (i % 64);
+    }
+  }
+  for (; from < w; --w) {
+    step<RECORD>(best, source, w - 1, cost, value, taken);
+  }
+}
+
+} // namespace
+
+void relax(std::uint64_t * const best, const std::uint64_t * const source, const std::size_t from, const std::size_t to,
+    const std::size_t cost, const std::uint64_t value, std::uint64_t * const taken) {
+  if (nullptr != taken) {
+    relax<true>(best, source, from, to, cost, value, taken);
+  } else {
+    relax<false>(best, source, from, to, cost, value, taken);
+  }
+}
+
+} // namespace avx2
+} // namespace simd
@@ -0,0 +1,58 @@
+#include "dp-kernel.h"
+
+namespace simd {
+
+namespace avx2 {
+void relax(std::uint64_t * best, const std::uint64_t * source, std::size_t from, std::size_t to,
+    std::size_t cost, std::uint64_t value, std::uint64_t * taken);
+} // namespace avx2
+
+Kernel detect() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? Kernel::AVX2 : Kernel::SCALAR;
+}
+
+namespace {
+
+Kernel current = detect();
+
+template<bool RECORD>
+void scalar(std::uint64_t * const best, const std::uint64_t * const source, const std::size_t from, std::size_t w,
+    const std::size_t cost, const std::uint64_t value, std::uint64_t * const taken) {
+  while (from < w--) {
+    const std::uint64_t take = source[w - cost] + value;
+    const bool better = source[w] < take;
+    best[w] = better ? take : source[w];
+    if (RECORD) {
+      taken[w / 64] |= std::uint64_t{better} << (w % 64);
+    }
+  }
+}
+
+} // namespace
+
+Kernel kernel() {
+  return current;
+}
+
+/* for benchmarks, asking for more than detect() falls back to it */
+void kernel(const Kernel k) {
+  current = static_cast<int>(k) <= static_cast<int>(detect()) ? k : detect();
+}
+
+const char * name(const Kernel k) {
+  return Kernel::AVX2 == k ? "avx2" : "scalar";
+}
+
+void relax(std::uint64_t * const best, const std::uint64_t * const source, const std::size_t from, const std::size_t to,
+    const std::size_t cost, const std::uint64_t value, std::uint64_t * const taken) {
+  if (Kernel::AVX2 == current) {
+    avx2::relax(best, source, from, to, cost, value, taken);
+  } else if (nullptr != taken) {
+    scalar<true>(best, source, from, to, cost, value, taken);
+  } else {
+    scalar<false>(best, source, from, to, cost, value, taken);
+  }
+}
+
+} // namespace simd
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * SIMD Knapsack Kernels
+ * ---------------------
+ * one item over a range of a DP row: for every w in [from, to)
+ *
+ *   best[w] = max(source[w], source[w - cost] + value)
+ *
+ * from the highest w down, so best may be source and the item is still
+ * taken at most once. where the item wins, bit w of taken is set, unless
+ * taken is null. values must stay below 2^63, the AVX2 kernel compares
+ * them as signed. from must not be less than cost.
+ *
+ * the kernel is picked once from CPUID: AVX2 or none.
+ */
+namespace simd {
+
+enum class Kernel { SCALAR, AVX2 };
+
+/* the best kernel this CPU supports */
+Kernel detect();
+
+/* the kernel in use, defaults to detect() */
+Kernel kernel();
+void kernel(Kernel);
+
+const char * name(Kernel);
+
+void relax(std::uint64_t * best, const std::uint64_t * source, std::size_t from, std::size_t to,
+    std::size_t cost, std::uint64_t value, std::uint64_t * taken);
+
+} // namespace simd
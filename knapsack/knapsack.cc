@@ -1,111 +1,173 @@
 /* knapsack from Design Algorithms */
 
-#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
-#include <map>
+#include <random>
+#include <string>
 #include <tuple>
-#include <vector>
 
-#include <cassert>
+#include "batch.h"
+#include "branch-and-bound.h"
+#include "knapsack.h"
 
-struct Item {
-  std::size_t cost;
-  std::size_t value;
-  bool operator < (const Item & other) const { return cost < other.cost; }
-};
-
-typedef std::vector<Item> Items;
+/* count items of cost 1 ... 4 capacity / count and value 1 ... 1000, so that about half of them fit */
+Items instance(const std::size_t count, const int capacity) {
+  std::mt19937_64 generator(count);
+  Items items(count);
+  for (auto & item : items) {
+    item.cost = 1 + generator() % std::max<std::size_t>(1, 4 * static_cast<std::size_t>(capacity) / count);
+    item.value = 1 + generator() % 1000;
+  }
+  std::sort(items.begin(), items.end());
+  return items;
+}
 
-Items knapsack(Items input, const int max_cost) {
-  std::map<int, std::map<int, std::vector<std::pair</* index */ int, /* total value */ int>>>> map;
-  std::sort(input.begin(), input.end());
+template<typename F>
+double time(F && f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
-  struct {
-    int value = 0;
-    int round = 0;
-    int cost = 0;
-  } greatest;
+/* the cost and value of a choice, checked against capacity */
+std::pair<std::size_t, std::size_t> total(const Items & items, const int capacity) {
+  std::size_t cost = 0, value = 0;
+  for (const auto & item : items) {
+    cost += item.cost;
+    value += item.value;
+  }
+  assert(static_cast<std::size_t>(capacity) >= cost);
+  return {cost, value};
+}
 
-  // first iteration, sets of only one element.
-  for (int i = 0; input.size() > i; ++i) {
-    const int total_cost = input[i].cost;
-    if (max_cost >= total_cost) {
-      map[total_cost][1].push_back({i, input[i].value});
-      if (greatest.value < input[i].value) {
-        greatest.value = input[i].value;
-        greatest.cost = total_cost;
-        greatest.round = 1;
+/*
+ * the best value alone for instance(count, capacity), with every kernel
+ * on one thread and with the best kernel on 2, 4 ... threads, then the
+ * items once.
+ */
+void benchmark(const std::size_t count, const int capacity, const std::size_t max_threads) {
+  const Items items = instance(count, capacity);
+  std::cout << count << " items, capacity " << capacity << std::endl;
+  std::uint64_t best = 0;
+  for (std::size_t threads = 1; max_threads >= threads; threads *= 2) {
+    for (const simd::Kernel kernel : {simd::Kernel::SCALAR, simd::Kernel::AVX2}) {
+      simd::kernel(kernel);
+      if (kernel != simd::kernel() || (1 < threads && simd::detect() != kernel)) {
+        continue;
       }
+      DynamicKnapsack::Values values;
+      const double seconds = time([&]() {
+        DynamicKnapsack(threads).fill(items.data(), items.data() + count, capacity, values);
+      });
+      assert(0 == best || best == values.back());
+      best = values.back();
+      std::cout << "  value " << best << ", " << simd::name(kernel) << ", " << threads << " threads: " << seconds << "s" << std::endl;
     }
   }
+  simd::kernel(simd::detect());
 
-  // rounds are subsets of two or more elements.
-  for (int round = 1; input.size() > round; ++round) {
-    for (auto & item : map) {
-      const int total_cost = item.first;
-      auto iterator = item.second.find(round);
-      if (item.second.end() != iterator) {
-        for (int i = 0; i < iterator->second.size(); ++i) {
-          const int last_index = iterator->second[i].first;
-          for (int j = last_index + 1; j < input.size(); ++j) {
-            const int new_total_cost = total_cost + input[j].cost;
-            if (max_cost >= new_total_cost) {
-              const int new_total_value = iterator->second[i].second + input[j].value;
-              map[new_total_cost][round + 1].push_back({j, new_total_value});
-              if (greatest.value < new_total_value) {
-                greatest.value = new_total_value;
-                greatest.cost = new_total_cost;
-                greatest.round = round + 1;
-              }
-            }
-          }
-        }
-      }
-    }
+  Items result;
+  const double seconds = time([&]() { result = DynamicKnapsack(max_threads)(items, capacity); });
+  const auto [cost, value] = total(result, capacity);
+  assert(best == value);
+  std::cout << "  items: " << result.size() << " taken, cost " << cost << ", value " << value << ", " << seconds << "s" << std::endl;
+}
+
+/*
+ * instance(count, capacity) by branch and bound, depth first, best first
+ * and depth first on a TaskPool, against the DP when its rows stay small.
+ */
+void branch_and_bound_benchmark(const std::size_t count, const int capacity, const std::size_t threads) {
+  const Items items = instance(count, capacity);
+  std::cout << count << " items, capacity " << capacity << std::endl;
+  std::size_t best = 0;
+  if (std::size_t{1} << 30 >= count * capacity) {
+    DynamicKnapsack::Values values;
+    const double seconds = time([&]() { DynamicKnapsack().fill(items.data(), items.data() + count, capacity, values); });
+    best = values.back();
+    std::cout << "  value " << best << ", dynamic programming: " << seconds << "s" << std::endl;
   }
 
-#if 0
-  /* dumps the built map */
-  for (const auto & item : map) {
-    for (const auto & item2 : item.second) {
-      for (const auto & item3 : item2.second) {
-        std::cout << item.first << ", " << item2.first << ", "
-          << item3.first << ", " << item3.second << std::endl;
-      }
-    }
+  TaskPool pool(threads);
+  using Order = BranchAndBoundKnapsack::Order;
+  for (const auto & [name, order, parallel] : {std::make_tuple("depth first", Order::DEPTH_FIRST, false),
+      std::make_tuple("best first", Order::BEST_FIRST, false), std::make_tuple("depth first, threads", Order::DEPTH_FIRST, true)}) {
+    BranchAndBoundKnapsack solver(order);
+    Items result;
+    const double seconds = time([&]() { result = parallel ? solver(pool, items, capacity) : solver(items, capacity); });
+    const auto [cost, value] = total(result, capacity);
+    assert(0 == best || best == value);
+    best = value;
+    std::cout << "  value " << value << ", cost " << cost << ", " << name << ": " << seconds << "s" << std::endl;
   }
-#endif
+}
 
-  std::vector<int> indexes;
-  indexes.reserve(greatest.round);
-  for (; 0 < greatest.round; --greatest.round) {
-    int index = -1, value = 0;
-    const auto & items = map[greatest.cost][greatest.round];
-    assert(!items.empty());
-    for (int i = items.size() - 1; 0 <= i; --i) {
-      if (indexes.empty() || items[i].first < indexes.back()) {
-        if (value <= items[i].second) {
-          value = items[i].second;
-          index = items[i].first;
-        }
-      }
+/*
+ * count random instances of 1 ... items items within capacity 1 ... capacity
+ * in the input format of KnapsackBatch, on out.
+ */
+void generate(const std::size_t count, const std::size_t items, const int capacity, const KnapsackBatch::Format format) {
+  std::mt19937_64 generator(count);
+  std::string output;
+  std::vector<std::uint32_t> binary;
+  for (std::size_t i = 0; count > i; ++i) {
+    const std::uint32_t n = 1 + generator() % items, max_cost = 1 + generator() % capacity;
+    binary.assign({max_cost, n});
+    output += std::to_string(max_cost);
+    for (std::uint32_t j = 0; n > j; ++j) {
+      const std::uint32_t cost = 1 + generator() % max_cost, value = 1 + generator() % 1000;
+      binary.insert(binary.end(), {cost, value});
+      output += ' ' + std::to_string(cost) + ' ' + std::to_string(value);
+    }
+    output += '\n';
+    if (KnapsackBatch::Format::BINARY == format) {
+      std::cout.write(reinterpret_cast<const char *>(binary.data()), binary.size() * sizeof(std::uint32_t));
+    } else {
+      std::cout << output;
     }
-    assert(0 <= index);
-    indexes.push_back(index);
-    greatest.cost -= input[index].cost;
+    output.clear();
   }
+}
 
-  Items result;
-  result.reserve(indexes.size());
-  for (const int index : indexes) {
-    result.push_back(input[index]);
+/* solves the instances of a file or stdin, reporting the throughput on stderr */
+int batch(const char * const path, const KnapsackBatch::Format format, const std::size_t threads) {
+  std::ifstream file;
+  if (nullptr != path && std::string("-") != path) {
+    file.open(path, std::ios::binary);
+    if ( ! file) {
+      std::cerr << "ERROR. cannot open \"" << path << "\"." << std::endl;
+      return 1;
+    }
   }
-
-  return result;
+  std::istream & in = file.is_open() ? file : std::cin;
+  std::ios::sync_with_stdio(false);
+  try {
+    std::size_t count = 0;
+    const double seconds = time([&]() { count = KnapsackBatch(threads)(in, std::cout, format); });
+    std::cerr << count << " instances, " << threads << " threads: " << seconds << "s, "
+      << count / seconds << " instances/s" << std::endl;
+  } catch (const std::exception & exception) {
+    std::cerr << "ERROR. " << exception.what() << std::endl;
+    return 1;
+  }
+  return 0;
 }
 
 int main(int argc, char * * argv) {
-  if (1 < argc) {
+  if (3 < argc && std::string("benchmark") == argv[1]) {
+    benchmark(std::stoul(argv[2]), std::stoi(argv[3]), 4 < argc ? std::stoul(argv[4]) : std::thread::hardware_concurrency());
+  } else if (3 < argc && std::string("branch-and-bound-benchmark") == argv[1]) {
+    branch_and_bound_benchmark(std::stoul(argv[2]), std::stoi(argv[3]),
+        4 < argc ? std::stoul(argv[4]) : std::thread::hardware_concurrency());
+  } else if (4 < argc && std::string("generate") == argv[1]) {
+    generate(std::stoul(argv[2]), std::stoul(argv[3]), std::stoi(argv[4]),
+        5 < argc && std::string("binary") == argv[5] ? KnapsackBatch::Format::BINARY : KnapsackBatch::Format::LINES);
+  } else if (1 < argc && std::string("batch") == argv[1]) {
+    return batch(3 < argc ? argv[3] : nullptr,
+        2 < argc && std::string("binary") == argv[2] ? KnapsackBatch::Format::BINARY : KnapsackBatch::Format::LINES,
+        4 < argc ? std::stoul(argv[4]) : std::thread::hardware_concurrency());
+  } else if (1 < argc) {
     Items items {{1, 1}, {2, 100}, {3, 9}, {4, 16}, {5, 25},};
 
     {
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+
+#include "dp-kernel.h"
+
+struct Item {
+  std::size_t cost;
+  std::size_t value;
+  bool operator < (const Item & other) const { return cost < other.cost; }
+};
+
+typedef std::vector<Item> Items;
+
+/* threads spin here until all of them arrived */
+class Barrier {
+public:
+  using size = std::size_t;
+
+  explicit Barrier(const size count) : count_(count) { }
+
+  void wait() {
+    const size generation = generation_.load(std::memory_order_acquire);
+    if (count_ == waiting_.fetch_add(1, std::memory_order_acq_rel) + 1) {
+      waiting_.store(0, std::memory_order_relaxed);
+      generation_.fetch_add(1, std::memory_order_release);
+      return;
+    }
+    while (generation == generation_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  const size count_;
+  std::atomic<size> waiting_{0};
+  std::atomic<size> generation_{0};
+};
+
+/*
+ * Dynamic Programming Knapsack
+ * ----------------------------
+ * 0/1 knapsack in O(n W) time over a single row: best[w] is the greatest
+ * value of the items seen so far within cost w, and every item updates
+ * it in place from the largest w down, so best[w - cost] still holds
+ * the row before the item and no item is taken twice. the update runs
+ * through the SIMD kernels.
+ *
+ * with more than one thread and rows of at least PARALLEL values per
+ * thread, every thread owns a slice of the capacity, 64 values aligned,
+ * and the row is written into a second buffer instead, swapped after a
+ * barrier at the end of every item.
+ *
+ * whether item i improved best[w] is kept in a bitset of n rows of W + 1
+ * bits, read backwards from W to recover the items. when that would take
+ * more than BITS, the items are split in halves, each half is solved for
+ * every capacity, the capacity is divided where the two halves add up to
+ * the best value and both halves recurse (Hirschberg), which keeps the
+ * memory at O(W) for a few more passes over the items.
+ *
+ * the buffers stay allocated between calls. items are returned from the
+ * most expensive to the cheapest, values must stay below 2^63.
+ */
+class DynamicKnapsack {
+public:
+  using size = std::size_t;
+  using Values = std::vector<std::uint64_t>;
+  static constexpr size BITS = size{1} << 31;
+  static constexpr size PARALLEL = 1 << 16;
+
+  explicit DynamicKnapsack(const size threads = 1) : threads_(std::max<size>(1, threads)) { }
+
+  Items operator()(Items input, const int max_cost) {
+    std::sort(input.begin(), input.end());
+    Items result;
+    if (0 > max_cost) {
+      return result;
+    }
+    solve(input.data(), input.data() + input.size(), max_cost, result);
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+
+  /* best[w] for the items in [first, last) within every cost w up to capacity */
+  void fill(const Item * const first, const Item * const last, const size capacity, Values & best) {
+    best.swap(run(first, last, capacity, nullptr));
+    /* best within cost w, not exactly w: carry the limit forward */
+    for (size w = 1; capacity >= w; ++w) {
+      best[w] = std::max(best[w], best[w - 1]);
+    }
+  }
+
+private:
+  /* the last row for the items in [first, last), with the bitset in taken unless it is null */
+  Values & run(const Item * const first, const Item * const last, const size capacity, std::uint64_t * const taken) {
+    const size n = last - first, words = capacity / 64 + 1;
+    rows_[0].assign(capacity + 1, 0);
+    if (1 == threads_ || PARALLEL * threads_ > capacity + 1) {
+      std::uint64_t * const best = rows_[0].data();
+      size limit = 0;
+      for (size i = 0; n > i; ++i) {
+        const size cost = first[i].cost;
+        /* only w up to the cost of all items so far can change */
+        limit = std::min(capacity, limit + cost);
+        if (cost <= limit) {
+          simd::relax(best, best, cost, limit + 1, cost, first[i].value, nullptr == taken ? nullptr : taken + i * words);
+        }
+      }
+      return rows_[0];
+    }
+
+    rows_[1].assign(capacity + 1, 0);
+    Barrier barrier(threads_);
+    const auto slice = [&](const size t) {
+      size limit = 0;
+      for (size i = 0; n > i; ++i) {
+        const size cost = first[i].cost;
+        limit = std::min(capacity, limit + cost);
+        const size chunk = ((limit + 1 + threads_ - 1) / threads_ + 63) / 64 * 64;
+        const size begin = std::min(limit + 1, t * chunk), end = std::min(limit + 1, begin + chunk);
+        const std::uint64_t * const source = rows_[i % 2].data();
+        std::uint64_t * const best = rows_[1 - i % 2].data();
+        std::copy(source + begin, source + std::max(begin, std::min(end, cost)), best + begin);
+        if (std::max(begin, cost) < end) {
+          simd::relax(best, source, std::max(begin, cost), end, cost, first[i].value,
+              nullptr == taken ? nullptr : taken + i * words);
+        }
+        barrier.wait();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size t = 1; threads_ > t; ++t) {
+      threads.emplace_back(slice, t);
+    }
+    slice(0);
+    for (auto & thread : threads) {
+      thread.join();
+    }
+    return rows_[n % 2];
+  }
+
+  /* appends the items of an optimal choice from [first, last) within capacity, cheapest first */
+  void solve(const Item * const first, const Item * const last, const size capacity, Items & result) {
+    const size n = last - first;
+    if (0 == n) {
+      return;
+    }
+    const size words = capacity / 64 + 1;
+    if (1 == n || BITS / 64 >= n * words) {
+      record(first, last, capacity, result);
+      return;
+    }
+    const Item * const middle = first + n / 2;
+    fill(first, middle, capacity, left_);
+    fill(middle, last, capacity, right_);
+    size split = 0;
+    for (size c = 1; capacity >= c; ++c) {
+      if (left_[split] + right_[capacity - split] < left_[c] + right_[capacity - c]) {
+        split = c;
+      }
+    }
+    solve(first, middle, split, result);
+    solve(middle, last, capacity - split, result);
+  }
+
+  void record(const Item * const first, const Item * const last, const size capacity, Items & result) {
+    const size n = last - first, words = capacity / 64 + 1;
+    taken_.assign(n * words, 0);
+    const Values & best = run(first, last, capacity, taken_.data());
+    size w = std::max_element(best.begin(), best.end()) - best.begin();
+    const size end = result.size();
+    for (size i = n; 0 < i--;) {
+      if (0 != (taken_[i * words + w / 64] >> (w % 64) & 1)) {
+        result.push_back(first[i]);
+        w -= first[i].cost;
+      }
+    }
+    std::reverse(result.begin() + end, result.end());
+  }
+
+  size threads_;
+  Values rows_[2], left_, right_;
+  std::vector<std::uint64_t> taken_;
+};
+
+inline Items knapsack(Items input, const int max_cost) {
+  return DynamicKnapsack()(std::move(input), max_cost);
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <unistd.h>
+
+#include "mergesort.h"
+
+/*
+ * External Mergesort
+ * ------------------
+ * sorts a file of fixed-size binary records of type T that does not fit
+ * in memory. the input is read in chunks that fit the memory budget,
+ * each chunk is sorted by BottomUpMergesort and spilled as a run in
+ * temp_directory. runs are then merged k at a time through a loser tree,
+ * every run reads ahead into a second block asynchronously while the
+ * first one is consumed and output is written the same way. when there
+ * are too many runs for the budget, groups are merged into longer runs
+ * first. stable, equal records keep their input order.
+ */
+template <typename T>
+class ExternalMergesort {
+  static_assert(std::is_trivially_copyable<T>::value, "records are read and written as raw bytes");
+
+public:
+  using size = std::size_t;
+
+  /* smallest block worth a read, a run needs two of them during a merge */
+  static constexpr size BLOCK = 1 << 16;
+
+  explicit ExternalMergesort(const size budget = size(256) << 20, std::string temp_directory = "/tmp") :
+    budget_(std::max(budget, 8 * BLOCK * sizeof(T))), temp_directory_(std::move(temp_directory)) { }
+
+  void operator()(const std::string & input, const std::string & output) {
+    Temporaries temporaries;
+    std::vector<std::string> runs = split(input, temporaries);
+    if (runs.empty()) {
+      close(open(output, "wb"));
+      return;
+    }
+    /* two blocks per run plus two for the output */
+    const size fan_in = std::max<size>(2, budget_ / (2 * BLOCK * sizeof(T)) - 1);
+    while (fan_in < runs.size()) {
+      std::vector<std::string> merged;
+      for (size i = 0; runs.size() > i; i += fan_in) {
+        const size last = std::min(runs.size(), i + fan_in);
+        if (1 == last - i) {
+          merged.push_back(runs[i]);
+          continue;
+        }
+        merged.push_back(temporary(temporaries));
+        merge(std::vector<std::string>(runs.begin() + i, runs.begin() + last), merged.back());
+      }
+      runs = std::move(merged);
+    }
+    merge(runs, output);
+  }
+
+private:
+  using File = std::FILE *;
+
+  /* the temporary files of a sort, removed however it ends */
+  struct Temporaries {
+    ~Temporaries() {
+      for (const auto & path : paths) {
+        std::remove(path.c_str());
+      }
+    }
+
+    std::vector<std::string> paths;
+  };
+
+  static File open(const std::string & path, const char * mode) {
+    File file = std::fopen(path.c_str(), mode);
+    if (nullptr == file) {
+      throw std::runtime_error("cannot open " + path);
+    }
+    return file;
+  }
+
+  static void close(File file) {
+    if (0 != std::fclose(file)) {
+      throw std::runtime_error("cannot close file");
+    }
+  }
+
+  static size read(File file, T * records, const size count) {
+    const size result = std::fread(records, sizeof(T), count, file);
+    if (count > result && std::ferror(file)) {
+      throw std::runtime_error("read error");
+    }
+    return result;
+  }
+
+  static void write(File file, const T * records, const size count) {
+    if (count != std::fwrite(records, sizeof(T), count, file)) {
+      throw std::runtime_error("write error");
+    }
+  }
+
+  std::string temporary(Temporaries & temporaries) const {
+    std::string path = temp_directory_ + "/mergesort-XXXXXX";
+    const int descriptor = mkstemp(path.data());
+    if (0 > descriptor) {
+      throw std::runtime_error("cannot create a temporary file in " + temp_directory_);
+    }
+    ::close(descriptor);
+    temporaries.paths.push_back(path);
+    return path;
+  }
+
+  /*
+   * sorted runs of input, half the budget holds a chunk and half its merge
+   * buffer. chunks are read as bytes, fread only comes back short at the
+   * end of the file, so a remainder there is a partial record.
+   */
+  std::vector<std::string> split(const std::string & input, Temporaries & temporaries) {
+    const std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(open(input, "rb"), std::fclose);
+    const size chunk = budget_ / (2 * sizeof(T));
+    std::unique_ptr<T[]> records(new T[chunk]);
+    MergeBuffer<T> buffer(chunk);
+    std::vector<std::string> runs;
+    while (true) {
+      const size bytes = std::fread(records.get(), 1, chunk * sizeof(T), file.get());
+      if (chunk * sizeof(T) > bytes && std::ferror(file.get())) {
+        throw std::runtime_error("read error");
+      }
+      if (0 != bytes % sizeof(T)) {
+        throw std::runtime_error(input + " is not a whole number of records");
+      }
+      const size count = bytes / sizeof(T);
+      if (0 == count) {
+        break;
+      }
+      BottomUpMergesort<T>()(records.get(), count, buffer);
+      runs.push_back(temporary(temporaries));
+      File run = open(runs.back(), "wb");
+      try {
+        write(run, records.get(), count);
+      } catch (...) {
+        std::fclose(run);
+        throw;
+      }
+      close(run);
+    }
+    return runs;
+  }
+
+  /* a run being merged, block[current] is consumed while the other one fills */
+  struct Reader {
+    Reader(const std::string & path, const size block) : file(open(path, "rb")) {
+      blocks[0].resize(block);
+      blocks[1].resize(block);
+      count = read(file, blocks[0].data(), block);
+      prefetch();
+    }
+
+    ~Reader() { if (pending.valid()) { pending.wait(); } std::fclose(file); }
+
+    bool exhausted() const { return position == count; }
+    const T & front() const { return blocks[current][position]; }
+
+    void next() {
+      if (count == ++position) {
+        count = pending.get();
+        current = 1 - current;
+        position = 0;
+        if (0 < count) {
+          prefetch();
+        }
+      }
+    }
+
+    void prefetch() {
+      T * block = blocks[1 - current].data();
+      const size length = blocks[1 - current].size();
+      pending = std::async(std::launch::async, [=]() { return read(file, block, length); });
+    }
+
+    File file;
+    std::vector<T> blocks[2];
+    size current = 0, position = 0, count = 0;
+    std::future<size> pending;
+  };
+
+  /* fills one block while the previous one is being written */
+  struct Writer {
+    Writer(const std::string & path, const size block) : file(open(path, "wb")) {
+      blocks[0].reserve(block);
+      blocks[1].reserve(block);
+    }
+
+    void push(const T & record) {
+      blocks[current].push_back(record);
+      if (blocks[current].capacity() == blocks[current].size()) {
+        flush();
+      }
+    }
+
+    void flush() {
+      if (pending.valid()) {
+        pending.get();
+      }
+      std::vector<T> & block = blocks[current];
+      pending = std::async(std::launch::async, [this, &block]() {
+        write(file, block.data(), block.size());
+        block.clear();
+      });
+      current = 1 - current;
+    }
+
+    ~Writer() {
+      if (pending.valid()) {
+        pending.wait();
+      }
+      if (nullptr != file) {
+        std::fclose(file);
+      }
+    }
+
+    void finish() {
+      flush();
+      pending.get();
+      File closing = file;
+      file = nullptr;
+      close(closing);
+    }
+
+    File file;
+    std::vector<T> blocks[2];
+    size current = 0;
+    std::future<void> pending;
+  };
+
+  /*
+   * tree_[0] is the run holding the smallest record, every other node
+   * keeps the loser of the match played there. leaves are implicit at
+   * k ... 2k - 1, exhausted runs lose to everything and ties go to the
+   * earlier run.
+   */
+  void merge(const std::vector<std::string> & runs, const std::string & output) {
+    const size k = runs.size();
+    const size block = std::max(BLOCK, budget_ / ((2 * k + 2) * sizeof(T)));
+    std::vector<std::unique_ptr<Reader>> readers;
+    for (const auto & run : runs) {
+      readers.emplace_back(new Reader(run, block));
+    }
+    Writer writer(output, block);
+
+    const auto less = [&readers](const size a, const size b) {
+      if (readers[a]->exhausted() || readers[b]->exhausted()) {
+        return ! readers[a]->exhausted() || (readers[b]->exhausted() && a < b);
+      }
+      return readers[a]->front() < readers[b]->front()
+        || ( ! (readers[b]->front() < readers[a]->front()) && a < b);
+    };
+
+    constexpr size NONE = std::numeric_limits<size>::max();
+    std::vector<size> tree(k, NONE);
+    const auto replay = [&](const size leaf) {
+      size winner = leaf;
+      for (size node = (leaf + k) / 2; 0 < node; node /= 2) {
+        if (NONE == tree[node]) {
+          tree[node] = winner;
+          return;
+        }
+        if (less(tree[node], winner)) {
+          std::swap(tree[node], winner);
+        }
+      }
+      tree[0] = winner;
+    };
+    for (size i = 0; k > i; ++i) {
+      replay(i);
+    }
+
+    while ( ! readers[tree[0]]->exhausted()) {
+      const size winner = tree[0];
+      writer.push(readers[winner]->front());
+      readers[winner]->next();
+      replay(winner);
+    }
+    writer.finish();
+
+    /* merged runs go early to free the disk, the rest when the sort ends */
+    readers.clear();
+    for (const auto & run : runs) {
+      std::remove(run.c_str());
+    }
+  }
+
+  size budget_;
+  std::string temp_directory_;
+};
@@ -0,0 +1,122 @@
+/* built with -mavx2 */
+
+#include <array>
+
+#include <immintrin.h>
+
+#include "merge-kernel.h"
+#include "merge-network.h"
+
+namespace simd {
+namespace avx2 {
+namespace {
+
+/*
+ * every type is shuffled as 8 lanes of 32 bits, a 64 bits element spans
+ * two lanes. E is how many lanes an element takes.
+ */
+template<std::size_t E>
+struct Lanes {
+  static constexpr std::size_t W = 8 / E;
+  using Array = std::array<int, 8>;
+
+  static constexpr Array indexes(const std::size_t d, const bool reverse) {
+    Array lanes{};
+    for (std::size_t i = 0; 8 > i; ++i) {
+      const std::size_t element = i / E;
+      lanes[i] = (reverse ? W - 1 - element : element ^ d) * E + i % E;
+    }
+    return lanes;
+  }
+
+  static constexpr Array mask(const std::size_t d) {
+    Array lanes{};
+    for (std::size_t i = 0; 8 > i; ++i) {
+      lanes[i] = 0 != ((i / E) & d) ? -1 : 0;
+    }
+    return lanes;
+  }
+
+  static __m256i vector(const Array & l) {
+    return _mm256_setr_epi32(l[0], l[1], l[2], l[3], l[4], l[5], l[6], l[7]);
+  }
+
+  static __m256i reverse(const __m256i x) {
+    constexpr Array index = indexes(0, true);
+    return _mm256_permutevar8x32_epi32(x, vector(index));
+  }
+
+  template<std::size_t D>
+  static __m256i exchange(const __m256i x) {
+    constexpr Array index = indexes(D, false);
+    return _mm256_permutevar8x32_epi32(x, vector(index));
+  }
+
+  template<std::size_t D>
+  static __m256i select(const __m256i low, const __m256i high) {
+    constexpr Array lanes = mask(D);
+    return _mm256_blendv_epi8(low, high, vector(lanes));
+  }
+};
+
+template<typename TYPE>
+struct Common : Lanes<sizeof(TYPE) / 4> {
+  using T = TYPE;
+  using R = __m256i;
+  static R load(const T * p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+  static void store(T * p, const R x) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x); }
+};
+
+struct Int32 : Common<std::int32_t> {
+  static R min(const R a, const R b) { return _mm256_min_epi32(a, b); }
+  static R max(const R a, const R b) { return _mm256_max_epi32(a, b); }
+  static bool special(R) { return false; }
+};
+
+/* AVX2 has no 64 bits min / max */
+struct Int64 : Common<std::int64_t> {
+  static R min(const R a, const R b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+  static R max(const R a, const R b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+  static bool special(R) { return false; }
+};
+
+struct Float : Common<float> {
+  static R min(const R a, const R b) { return _mm256_castps_si256(_mm256_min_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b))); }
+  static R max(const R a, const R b) { return _mm256_castps_si256(_mm256_max_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b))); }
+  static bool special(const R x) {
+    const __m256 f = _mm256_castsi256_ps(x);
+    const __m256i negative_zero = _mm256_cmpeq_epi32(x, _mm256_set1_epi32(0x80000000));
+    return 0 != (_mm256_movemask_ps(_mm256_cmp_ps(f, f, _CMP_UNORD_Q)) | _mm256_movemask_epi8(negative_zero));
+  }
+};
+
+struct Double : Common<double> {
+  static R min(const R a, const R b) { return _mm256_castpd_si256(_mm256_min_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b))); }
+  static R max(const R a, const R b) { return _mm256_castpd_si256(_mm256_max_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b))); }
+  static bool special(const R x) {
+    const __m256d d = _mm256_castsi256_pd(x);
+    const __m256i negative_zero = _mm256_cmpeq_epi64(x, _mm256_set1_epi64x(0x8000000000000000));
+    return 0 != (_mm256_movemask_pd(_mm256_cmp_pd(d, d, _CMP_UNORD_Q)) | _mm256_movemask_epi8(negative_zero));
+  }
+};
+
+} // namespace
+
+bool merge(const std::int32_t * a, const std::size_t a_size, const std::int32_t * b, const std::size_t b_size, std::int32_t * output) {
+  return network::merge<Int32>(a, a_size, b, b_size, output);
+}
+
+bool merge(const std::int64_t * a, const std::size_t a_size, const std::int64_t * b, const std::size_t b_size, std::int64_t * output) {
+  return network::merge<Int64>(a, a_size, b, b_size, output);
+}
+
+bool merge(const float * a, const std::size_t a_size, const float * b, const std::size_t b_size, float * output) {
+  return network::merge<Float>(a, a_size, b, b_size, output);
+}
+
+bool merge(const double * a, const std::size_t a_size, const double * b, const std::size_t b_size, double * output) {
+  return network::merge<Double>(a, a_size, b, b_size, output);
+}
+
+} // namespace avx2
+} // namespace simd
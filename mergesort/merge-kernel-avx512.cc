@@ -0,0 +1,120 @@
+/* built with -mavx512f */
+
+#include <array>
+
+#include <immintrin.h>
+
+#include "merge-kernel.h"
+#include "merge-network.h"
+
+namespace simd {
+namespace avx512 {
+namespace {
+
+/*
+ * every type is shuffled as 16 lanes of 32 bits, a 64 bits element
+ * spans two lanes. E is how many lanes an element takes.
+ */
+template<std::size_t E>
+struct Lanes {
+  static constexpr std::size_t W = 16 / E;
+  using Array = std::array<int, 16>;
+
+  static constexpr Array indexes(const std::size_t d, const bool reverse) {
+    Array lanes{};
+    for (std::size_t i = 0; 16 > i; ++i) {
+      const std::size_t element = i / E;
+      lanes[i] = (reverse ? W - 1 - element : element ^ d) * E + i % E;
+    }
+    return lanes;
+  }
+
+  static constexpr __mmask16 mask(const std::size_t d) {
+    __mmask16 lanes = 0;
+    for (std::size_t i = 0; 16 > i; ++i) {
+      lanes |= 0 != ((i / E) & d) ? 1 << i : 0;
+    }
+    return lanes;
+  }
+
+  static __m512i vector(const Array & l) {
+    return _mm512_setr_epi32(l[0], l[1], l[2], l[3], l[4], l[5], l[6], l[7],
+        l[8], l[9], l[10], l[11], l[12], l[13], l[14], l[15]);
+  }
+
+  static __m512i reverse(const __m512i x) {
+    constexpr Array index = indexes(0, true);
+    return _mm512_permutexvar_epi32(vector(index), x);
+  }
+
+  template<std::size_t D>
+  static __m512i exchange(const __m512i x) {
+    constexpr Array index = indexes(D, false);
+    return _mm512_permutexvar_epi32(vector(index), x);
+  }
+
+  template<std::size_t D>
+  static __m512i select(const __m512i low, const __m512i high) {
+    constexpr __mmask16 lanes = mask(D);
+    return _mm512_mask_blend_epi32(lanes, low, high);
+  }
+};
+
+template<typename TYPE>
+struct Common : Lanes<sizeof(TYPE) / 4> {
+  using T = TYPE;
+  using R = __m512i;
+  static R load(const T * p) { return _mm512_loadu_si512(p); }
+  static void store(T * p, const R x) { _mm512_storeu_si512(p, x); }
+};
+
+struct Int32 : Common<std::int32_t> {
+  static R min(const R a, const R b) { return _mm512_min_epi32(a, b); }
+  static R max(const R a, const R b) { return _mm512_max_epi32(a, b); }
+  static bool special(R) { return false; }
+};
+
+struct Int64 : Common<std::int64_t> {
+  static R min(const R a, const R b) { return _mm512_min_epi64(a, b); }
+  static R max(const R a, const R b) { return _mm512_max_epi64(a, b); }
+  static bool special(R) { return false; }
+};
+
+struct Float : Common<float> {
+  static R min(const R a, const R b) { return _mm512_castps_si512(_mm512_min_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b))); }
+  static R max(const R a, const R b) { return _mm512_castps_si512(_mm512_max_ps(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b))); }
+  static bool special(const R x) {
+    const __m512 f = _mm512_castsi512_ps(x);
+    return 0 != (_mm512_cmp_ps_mask(f, f, _CMP_UNORD_Q) | _mm512_cmpeq_epi32_mask(x, _mm512_set1_epi32(0x80000000)));
+  }
+};
+
+struct Double : Common<double> {
+  static R min(const R a, const R b) { return _mm512_castpd_si512(_mm512_min_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b))); }
+  static R max(const R a, const R b) { return _mm512_castpd_si512(_mm512_max_pd(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b))); }
+  static bool special(const R x) {
+    const __m512d d = _mm512_castsi512_pd(x);
+    return 0 != (_mm512_cmp_pd_mask(d, d, _CMP_UNORD_Q) | _mm512_cmpeq_epi64_mask(x, _mm512_set1_epi64(0x8000000000000000)));
+  }
+};
+
+} // namespace
+
+bool merge(const std::int32_t * a, const std::size_t a_size, const std::int32_t * b, const std::size_t b_size, std::int32_t * output) {
+  return network::merge<Int32>(a, a_size, b, b_size, output);
+}
+
+bool merge(const std::int64_t * a, const std::size_t a_size, const std::int64_t * b, const std::size_t b_size, std::int64_t * output) {
+  return network::merge<Int64>(a, a_size, b, b_size, output);
+}
+
+bool merge(const float * a, const std::size_t a_size, const float * b, const std::size_t b_size, float * output) {
+  return network::merge<Float>(a, a_size, b, b_size, output);
+}
+
+bool merge(const double * a, const std::size_t a_size, const double * b, const std::size_t b_size, double * output) {
+  return network::merge<Double>(a, a_size, b, b_size, output);
+}
+
+} // namespace avx512
+} // namespace simd
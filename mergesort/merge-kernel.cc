@@ -0,0 +1,72 @@
+#include "merge-kernel.h"
+
+namespace simd {
+
+#define DECLARE_MERGE(T) \
+  bool merge(const T * a, std::size_t a_size, const T * b, std::size_t b_size, T * output);
+
+namespace avx2 {
+DECLARE_MERGE(std::int32_t)
+DECLARE_MERGE(std::int64_t)
+DECLARE_MERGE(float)
+DECLARE_MERGE(double)
+} // namespace avx2
+
+namespace avx512 {
+DECLARE_MERGE(std::int32_t)
+DECLARE_MERGE(std::int64_t)
+DECLARE_MERGE(float)
+DECLARE_MERGE(double)
+} // namespace avx512
+
+#undef DECLARE_MERGE
+
+Kernel detect() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Kernel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return Kernel::AVX2;
+  }
+  return Kernel::SCALAR;
+}
+
+namespace {
+Kernel current = detect();
+} // namespace
+
+Kernel kernel() {
+  return current;
+}
+
+/* for benchmarks, asking for more than detect() falls back to it */
+void kernel(const Kernel k) {
+  current = static_cast<int>(k) <= static_cast<int>(detect()) ? k : detect();
+}
+
+const char * name(const Kernel k) {
+  switch (k) {
+  case Kernel::AVX512: return "avx512";
+  case Kernel::AVX2: return "avx2";
+  default: return "scalar";
+  }
+}
+
+#define DEFINE_MERGE(T) \
+  bool merge(const T * a, const std::size_t a_size, const T * b, const std::size_t b_size, T * output) { \
+    switch (current) { \
+    case Kernel::AVX512: return avx512::merge(a, a_size, b, b_size, output); \
+    case Kernel::AVX2: return avx2::merge(a, a_size, b, b_size, output); \
+    default: return false; \
+    } \
+  }
+
+DEFINE_MERGE(std::int32_t)
+DEFINE_MERGE(std::int64_t)
+DEFINE_MERGE(float)
+DEFINE_MERGE(double)
+
+#undef DEFINE_MERGE
+
+} // namespace simd
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * SIMD Merge Kernels
+ * ------------------
+ * merge two sorted arrays of primitive keys into output, a vector width
+ * at a time through a bitonic merge network, without data dependent
+ * branches. the kernel is picked once from CPUID: AVX-512, AVX2 or none.
+ *
+ * merge returns false when it did not merge and the caller has to run
+ * its scalar merge instead: no kernel, inputs shorter than a vector, or
+ * floating point input holding -0.0 or NaN, whose relative order the
+ * networks cannot reproduce. output must not overlap the inputs.
+ */
+namespace simd {
+
+enum class Kernel { SCALAR, AVX2, AVX512 };
+
+/* the best kernel this CPU supports */
+Kernel detect();
+
+/* the kernel in use, defaults to detect() */
+Kernel kernel();
+void kernel(Kernel);
+
+const char * name(Kernel);
+
+bool merge(const std::int32_t * a, std::size_t a_size, const std::int32_t * b, std::size_t b_size, std::int32_t * output);
+bool merge(const std::int64_t * a, std::size_t a_size, const std::int64_t * b, std::size_t b_size, std::int64_t * output);
+bool merge(const float * a, std::size_t a_size, const float * b, std::size_t b_size, float * output);
+bool merge(const double * a, std::size_t a_size, const double * b, std::size_t b_size, double * output);
+
+template<typename T>
+struct Mergeable : std::integral_constant<bool,
+  std::is_same<T, std::int32_t>::value || std::is_same<T, std::int64_t>::value
+  || std::is_same<T, float>::value || std::is_same<T, double>::value> { };
+
+} // namespace simd
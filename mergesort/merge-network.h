@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+ * the merge loop shared by the kernels, each ISA translation unit
+ * includes it after defining its register operations V:
+ *
+ *   using T, R; static constexpr std::size_t W (lanes of T);
+ *   R load(const T *); void store(T *, R);
+ *   R min(R, R); R max(R, R);
+ *   R reverse(R);
+ *   template<std::size_t D> R exchange(R) (lane i takes lane i ^ D);
+ *   template<std::size_t D> R select(R low, R high) (high where i & D);
+ *   bool special(R) (holds -0.0 or NaN).
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace simd {
+namespace network {
+
+template<class V, std::size_t D>
+inline typename V::R clean(typename V::R x) {
+  if constexpr (0 < D) {
+    const typename V::R y = V::template exchange<D>(x);
+    x = V::template select<D>(V::min(x, y), V::max(x, y));
+    return clean<V, D / 2>(x);
+  } else {
+    return x;
+  }
+}
+
+/* a and b sorted, afterwards a holds the lower half and b the upper, both sorted */
+template<class V>
+inline void bitonic(typename V::R & a, typename V::R & b) {
+  const typename V::R reversed = V::reverse(b);
+  const typename V::R low = V::min(a, reversed), high = V::max(a, reversed);
+  a = clean<V, V::W / 2>(low);
+  b = clean<V, V::W / 2>(high);
+}
+
+template<typename T>
+inline bool special(const T * first, const T * last) {
+  if constexpr (std::is_floating_point<T>::value) {
+    for (; last != first; ++first) {
+      if (std::isnan(*first) || (0 == *first && std::signbit(*first))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template<typename T>
+inline T * merge_scalar(const T * a, const T * a_last, const T * b, const T * b_last, T * output) {
+  while (a_last != a && b_last != b) {
+    *output++ = *b < *a ? *b++ : *a++;
+  }
+  output = std::copy(a, a_last, output);
+  return std::copy(b, b_last, output);
+}
+
+template<class V>
+bool merge(const typename V::T * a, const std::size_t a_size, const typename V::T * b, const std::size_t b_size, typename V::T * output) {
+  using T = typename V::T;
+  using R = typename V::R;
+  constexpr std::size_t W = V::W;
+  if (W > a_size || W > b_size) {
+    return false;
+  }
+  const T * const a_last = a + a_size, * const b_last = b + b_size;
+  R low = V::load(a), high = V::load(b);
+  a += W;
+  b += W;
+  if (V::special(low) || V::special(high)) {
+    return false;
+  }
+  bitonic<V>(low, high);
+  V::store(output, low);
+  output += W;
+
+  /* high keeps the largest W seen, the next block comes from the input with the smaller head */
+  while (true) {
+    const bool from_b = b_last != b && (a_last == a || *b < *a);
+    const T * & source = from_b ? b : a;
+    if (W > static_cast<std::size_t>((from_b ? b_last : a_last) - source)) {
+      break;
+    }
+    low = V::load(source);
+    source += W;
+    if (V::special(low)) {
+      return false;
+    }
+    bitonic<V>(low, high);
+    V::store(output, low);
+    output += W;
+  }
+
+  /* one input has less than W left: merge it with high, then with the other one */
+  T rest[W], small[2 * W];
+  V::store(rest, high);
+  if (special(a, a_last) || special(b, b_last)) {
+    return false;
+  }
+  const bool a_short = W > static_cast<std::size_t>(a_last - a) && (W <= static_cast<std::size_t>(b_last - b) || a_last - a <= b_last - b);
+  const T * short_first = a_short ? a : b, * short_last = a_short ? a_last : b_last;
+  const T * long_first = a_short ? b : a, * long_last = a_short ? b_last : a_last;
+  T * const small_last = merge_scalar(rest, rest + W, short_first, short_last, small);
+  merge_scalar(small, small_last, long_first, long_last, output);
+  return true;
+}
+
+} // namespace network
+} // namespace simd
@@ -1,42 +1,163 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cmath>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
-template <typename T>
-class Mergesort {
-public:
-  void operator()(T * array, const std::size_t size) {
-    aux = new T[size];
-    mergesort(array, size);
-    delete [] aux;
-    aux = nullptr;
-  }
-private:
-  void mergesort(T * array, const std::size_t size) {
-    if (2 < size) {
-      const auto half = size / 2; // this is always an integer division 5 / 2 = 2.
-      mergesort(array, half);
-      mergesort(array + half, size - half);
-      for (int i = 0, j = 0, k = half; size > i; ++i) {
-        if (half > j && (size == k || array[j] < array[k])) {
-          aux[i] = array[j];
-          ++j;
-        } else {
-          aux[i] = array[k];
-          ++k;
-        }
-      }
-      std::copy(aux, aux + size, array);
-    } else if (2 == size) {
-      if (array[0] > array[1]) {
-        std::swap(array[0], array[1]);
+#include <cassert>
+
+#include "external-mergesort.h"
+#include "mergesort.h"
+
+template<class SORT>
+double time(std::vector<int> array, SORT && sort) {
+  const auto start = std::chrono::steady_clock::now();
+  sort(array.data(), array.size());
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  assert(std::is_sorted(array.begin(), array.end()));
+  return seconds;
+}
+
+/*
+ * compares the serial variants on random, sorted and nearly sorted
+ * input, then sorts the random input with 1, 2, 4 ...
+ * max_threads threads.
+ */
+void benchmark(const std::size_t size, const std::size_t max_threads) {
+  std::vector<int> input(size), sorted(size), nearly_sorted(size);
+  std::mt19937 generator(size);
+  for (std::size_t i = 0; size > i; ++i) {
+    input[i] = generator();
+    sorted[i] = nearly_sorted[i] = i;
+  }
+  /* an appended log, 1% of the entries arrive up to a thousand places late */
+  for (std::size_t i = 0; size / 100 > i; ++i) {
+    const std::size_t j = generator() % size;
+    nearly_sorted[j] -= std::min<std::size_t>(j, generator() % 1000);
+  }
+
+  for (const auto & [name, data] : {std::make_pair("random", &input), std::make_pair("sorted", &sorted), std::make_pair("nearly sorted", &nearly_sorted)}) {
+    std::cout << name << std::endl;
+    std::cout << "  Mergesort: " << time(*data, Mergesort<int>()) << "s" << std::endl;
+    std::cout << "  BottomUpMergesort: " << time(*data, BottomUpMergesort<int>()) << "s" << std::endl;
+    {
+      MergeBuffer<int> buffer(size);
+      std::cout << "  BottomUpMergesort, reused buffer: " << time(*data, [&buffer](int * array, const std::size_t size) {
+        BottomUpMergesort<int>()(array, size, buffer);
+      }) << "s" << std::endl;
+    }
+    std::cout << "  AdaptiveMergesort: " << time(*data, AdaptiveMergesort<int>()) << "s" << std::endl;
+    std::cout << "  std::stable_sort: " << time(*data, [](int * array, const std::size_t size) {
+      std::stable_sort(array, array + size);
+    }) << "s" << std::endl;
+  }
+
+  double serial = 0;
+  std::cout << "threads, seconds, speed-up" << std::endl;
+  for (std::size_t threads = 1; max_threads >= threads; threads *= 2) {
+    TaskPool pool(threads);
+    const double seconds = time(input, Mergesort<int>(pool));
+    if (1 == threads) {
+      serial = seconds;
+    }
+    std::cout << threads << ", " << seconds << ", " << serial / seconds << std::endl;
+  }
+}
+
+/* sorts random keys of type T with every merge kernel the CPU has, results must be identical */
+template<typename T>
+void simd_benchmark(const char * type, const std::size_t size) {
+  std::vector<T> input(size);
+  std::mt19937_64 generator(size);
+  for (auto & item : input) {
+    item = static_cast<T>(static_cast<std::int64_t>(generator()) >> (64 - 8 * sizeof(T)));
+  }
+  std::vector<T> expected;
+  for (const simd::Kernel kernel : {simd::Kernel::SCALAR, simd::Kernel::AVX2, simd::Kernel::AVX512}) {
+    if (static_cast<int>(simd::detect()) < static_cast<int>(kernel)) {
+      continue;
+    }
+    simd::kernel(kernel);
+    std::vector<T> array(input);
+    const auto start = std::chrono::steady_clock::now();
+    BottomUpMergesort<T>()(array.data(), size);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (expected.empty()) {
+      expected = array;
+    }
+    assert(expected == array);
+    std::cout << type << ", " << simd::name(kernel) << ": " << seconds << "s" << std::endl;
+  }
+  simd::kernel(simd::detect());
+}
+
+/* writes size random 64 bits records, sorts them out of core and checks the output */
+void external_benchmark(const std::size_t size, const std::size_t budget, const std::string & temp_directory) {
+  using Record = std::uint64_t;
+  const std::string input = temp_directory + "/mergesort-input", output = temp_directory + "/mergesort-output";
+  {
+    std::vector<Record> records(1 << 20);
+    std::mt19937_64 generator(size);
+    std::FILE * file = std::fopen(input.c_str(), "wb");
+    assert(nullptr != file);
+    for (std::size_t i = 0; size > i; i += records.size()) {
+      const std::size_t count = std::min(records.size(), size - i);
+      for (std::size_t j = 0; count > j; ++j) {
+        records[j] = generator();
       }
+      std::fwrite(records.data(), sizeof(Record), count, file);
     }
+    std::fclose(file);
   }
-  T * aux = nullptr;
-};
+
+  const auto start = std::chrono::steady_clock::now();
+  ExternalMergesort<Record>(budget, temp_directory)(input, output);
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << size << " records (" << (size * sizeof(Record) >> 20) << "MB), budget "
+    << (budget >> 20) << "MB: " << seconds << "s" << std::endl;
+
+  {
+    std::vector<Record> records(1 << 20);
+    std::FILE * file = std::fopen(output.c_str(), "rb");
+    assert(nullptr != file);
+    std::size_t total = 0;
+    Record last = 0;
+    for (std::size_t count; 0 < (count = std::fread(records.data(), sizeof(Record), records.size(), file));) {
+      assert(last <= records[0]);
+      assert(std::is_sorted(records.begin(), records.begin() + count));
+      last = records[count - 1];
+      total += count;
+    }
+    std::fclose(file);
+    assert(size == total);
+  }
+  std::remove(input.c_str());
+  std::remove(output.c_str());
+}
 
 int main(int argc, char * * argv) {
-  if (1 < argc) {
+  if (2 < argc && std::string("benchmark") == argv[1]) {
+    benchmark(std::stoul(argv[2]), 3 < argc ? std::stoul(argv[3]) : std::thread::hardware_concurrency());
+  } else if (2 < argc && std::string("simd-benchmark") == argv[1]) {
+    const std::size_t size = std::stoul(argv[2]);
+    simd_benchmark<std::int32_t>("int32", size);
+    simd_benchmark<std::int64_t>("int64", size);
+    simd_benchmark<float>("float", size);
+    simd_benchmark<double>("double", size);
+  } else if (2 < argc && std::string("external-benchmark") == argv[1]) {
+    external_benchmark(std::stoul(argv[2]), (3 < argc ? std::stoul(argv[3]) : 256) << 20, 4 < argc ? argv[4] : "/tmp");
+  } else if (3 < argc && std::string("external") == argv[1]) {
+    /* sorts a file of unsigned 64 bits integers */
+    try {
+      ExternalMergesort<std::uint64_t>((4 < argc ? std::stoul(argv[4]) : 256) << 20, 5 < argc ? argv[5] : "/tmp")(argv[2], argv[3]);
+    } catch (const std::runtime_error & error) {
+      std::cerr << "ERROR. " << error.what() << std::endl;
+      return 1;
+    }
+  } else if (1 < argc) {
     const std::size_t size = std::atoi(argv[1]);
     auto array = new int[size];
     srand(time(nullptr));
@@ -51,7 +172,11 @@ int main(int argc, char * * argv) {
     delete [] array;
     array = nullptr;
   } else {
-    std::cerr << "usage: " << argv[0] << " size of the array.";
+    std::cerr << "usage: " << argv[0] << " size of the array." << std::endl
+      << "       " << argv[0] << " benchmark size [threads]" << std::endl
+      << "       " << argv[0] << " simd-benchmark size" << std::endl
+      << "       " << argv[0] << " external input output [budget in MB] [temp directory]" << std::endl
+      << "       " << argv[0] << " external-benchmark size [budget in MB] [temp directory]" << std::endl;
   }
   return 0;
 }
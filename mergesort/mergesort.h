@@ -0,0 +1,576 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "merge-kernel.h"
+#include "task-pool.h"
+
+template <typename T>
+class Mergesort {
+public:
+  Mergesort() = default;
+
+  /*
+   * parallel mode: halves above CUTOFF elements are forked as tasks and
+   * merges above MERGE_CUTOFF are split across the pool by co-ranking.
+   */
+  explicit Mergesort(TaskPool & pool) : pool_(&pool) { }
+
+  void operator()(T * array, const std::size_t size) {
+    aux = new T[size];
+    if (nullptr != pool_ && CUTOFF < size) {
+      parallel_mergesort(array, aux, size);
+    } else {
+      mergesort(array, size);
+    }
+    delete [] aux;
+    aux = nullptr;
+  }
+
+private:
+  static constexpr std::size_t CUTOFF = 1 << 14;
+  static constexpr std::size_t MERGE_CUTOFF = 1 << 16;
+
+  void mergesort(T * array, const std::size_t size) {
+    mergesort(array, aux, size);
+  }
+
+  /* aux is scratch space as large as array */
+  static void mergesort(T * array, T * aux, const std::size_t size) {
+    if (2 < size) {
+      const auto half = size / 2; // this is always an integer division 5 / 2 = 2.
+      mergesort(array, aux, half);
+      mergesort(array + half, aux + half, size - half);
+      merge(array, half, array + half, size - half, aux);
+      std::copy(aux, aux + size, array);
+    } else if (2 == size) {
+      if (array[1] < array[0]) {
+        std::swap(array[0], array[1]);
+      }
+    }
+  }
+
+  static void merge(const T * a, const std::size_t a_size, const T * b, const std::size_t b_size, T * output) {
+    if constexpr (simd::Mergeable<T>::value) {
+      if (simd::merge(a, a_size, b, b_size, output)) {
+        return;
+      }
+    }
+    const std::size_t size = a_size + b_size;
+    for (std::size_t i = 0, j = 0, k = 0; size > i; ++i) {
+      /* ties are taken from a, which keeps the sort stable */
+      if (a_size > j && (b_size == k || ! (b[k] < a[j]))) {
+        output[i] = a[j];
+        ++j;
+      } else {
+        output[i] = b[k];
+        ++k;
+      }
+    }
+  }
+
+  void parallel_mergesort(T * array, T * aux, const std::size_t size) {
+    if (CUTOFF >= size) {
+      mergesort(array, aux, size);
+      return;
+    }
+    const auto half = size / 2;
+    TaskPool::Group group;
+    pool_->spawn(group, [=]() { parallel_mergesort(array, aux, half); });
+    parallel_mergesort(array + half, aux + half, size - half);
+    pool_->wait(group);
+    if (MERGE_CUTOFF < size) {
+      parallel_merge(array, half, array + half, size - half, aux);
+    } else {
+      merge(array, half, array + half, size - half, aux);
+      std::copy(aux, aux + size, array);
+    }
+  }
+
+  /*
+   * how many of the first k merged elements come from a, found by binary
+   * search so that a[i - 1] <= b[k - i] and b[k - i - 1] < a[i], which
+   * agrees with merge on ties.
+   */
+  static std::size_t co_rank(const std::size_t k, const T * a, const std::size_t a_size, const T * b, const std::size_t b_size) {
+    std::size_t low = k > b_size ? k - b_size : 0;
+    std::size_t high = std::min(k, a_size);
+    while (low < high) {
+      const std::size_t i = low + (high - low) / 2;
+      if ( ! (b[k - i - 1] < a[i])) {
+        low = i + 1;
+      } else {
+        high = i;
+      }
+    }
+    return low;
+  }
+
+  /* splits the output in one slice per thread, every slice merges and copies back on its own */
+  void parallel_merge(T * a, const std::size_t a_size, T * b, const std::size_t b_size, T * output) {
+    const std::size_t size = a_size + b_size;
+    const std::size_t slices = std::min(pool_->threads() * 4, size / (MERGE_CUTOFF / 4));
+    TaskPool::Group group;
+    for (std::size_t s = 0; slices > s; ++s) {
+      pool_->spawn(group, [=]() {
+        const std::size_t first = size * s / slices, last = size * (s + 1) / slices;
+        const std::size_t i = co_rank(first, a, a_size, b, b_size), j = first - i;
+        const std::size_t i_last = co_rank(last, a, a_size, b, b_size), j_last = last - i_last;
+        merge(a + i, i_last - i, b + j, j_last - j, output + first);
+      });
+    }
+    pool_->wait(group);
+    /* a and b are contiguous, a's start is the start of the merged range */
+    TaskPool::Group copy;
+    for (std::size_t s = 0; slices > s; ++s) {
+      pool_->spawn(copy, [=]() {
+        const std::size_t first = size * s / slices, last = size * (s + 1) / slices;
+        std::copy(output + first, output + last, a + first);
+      });
+    }
+    pool_->wait(copy);
+  }
+
+  T * aux = nullptr;
+  TaskPool * pool_ = nullptr;
+};
+
+/*
+ * uninitialized storage for merging, nothing is constructed until a
+ * sort moves elements in and everything is destroyed again before it
+ * returns. reuse one buffer across calls to sort without reallocating.
+ */
+template <typename T>
+class MergeBuffer {
+public:
+  MergeBuffer() = default;
+  explicit MergeBuffer(const std::size_t capacity) { reserve(capacity); }
+  ~MergeBuffer() { release(); }
+
+  MergeBuffer(const MergeBuffer &) = delete;
+  MergeBuffer & operator = (const MergeBuffer &) = delete;
+
+  void reserve(const std::size_t capacity) {
+    if (capacity_ < capacity) {
+      release();
+      data_ = std::allocator<T>().allocate(capacity);
+      capacity_ = capacity;
+    }
+  }
+
+  T * data() const { return data_; }
+  std::size_t capacity() const { return capacity_; }
+
+private:
+  void release() {
+    if (nullptr != data_) {
+      std::allocator<T>().deallocate(data_, capacity_);
+      data_ = nullptr;
+      capacity_ = 0;
+    }
+  }
+
+  T * data_ = nullptr;
+  std::size_t capacity_ = 0;
+};
+
+/*
+ * Bottom-up Mergesort
+ * -------------------
+ * insertion sorts runs of RUN elements, then merges runs of doubling
+ * width back and forth between array and buffer instead of copying back
+ * after every merge. when the number of passes is odd the runs are
+ * sorted inside the buffer, so the last pass always lands in array.
+ * stable, ties are taken from the left run.
+ */
+template <typename T>
+class BottomUpMergesort {
+public:
+  static constexpr std::size_t RUN = 24;
+
+  void operator()(T * array, const std::size_t size) {
+    MergeBuffer<T> buffer(size);
+    operator()(array, size, buffer);
+  }
+
+  void operator()(T * array, const std::size_t size, MergeBuffer<T> & buffer) {
+    if (RUN >= size) {
+      insertion_sort(array, size);
+      return;
+    }
+    buffer.reserve(size);
+    T * const other = buffer.data();
+
+    std::size_t passes = 0;
+    for (std::size_t width = RUN; size > width; width *= 2) {
+      ++passes;
+    }
+
+    T * source = array, * destination = other;
+    bool constructed = false;
+    if (1 == passes % 2) {
+      std::swap(source, destination);
+      constructed = true;
+    }
+    for (std::size_t i = 0; size > i; i += RUN) {
+      const std::size_t length = std::min(RUN, size - i);
+      if (constructed) {
+        std::uninitialized_move(array + i, array + i + length, other + i);
+      }
+      insertion_sort(source + i, length);
+    }
+
+    for (std::size_t width = RUN; size > width; width *= 2) {
+      for (std::size_t i = 0; size > i; i += 2 * width) {
+        const std::size_t middle = std::min(i + width, size), last = std::min(i + 2 * width, size);
+        if (constructed) {
+          merge<false>(source + i, source + middle, source + middle, source + last, destination + i);
+        } else {
+          merge<true>(source + i, source + middle, source + middle, source + last, destination + i);
+        }
+      }
+      constructed = true;
+      std::swap(source, destination);
+    }
+    std::destroy(other, other + size);
+  }
+
+private:
+  static void insertion_sort(T * array, const std::size_t size) {
+    for (std::size_t i = 1; size > i; ++i) {
+      T item{std::move(array[i])};
+      std::size_t j = i;
+      for (; 0 < j && item < array[j - 1]; --j) {
+        array[j] = std::move(array[j - 1]);
+      }
+      array[j] = std::move(item);
+    }
+  }
+
+  /* CONSTRUCT when output is still raw storage */
+  template<bool CONSTRUCT>
+  static void merge(T * a, T * const a_last, T * b, T * const b_last, T * output) {
+    if constexpr (simd::Mergeable<T>::value) {
+      if (simd::merge(a, a_last - a, b, b_last - b, output)) {
+        return;
+      }
+    }
+    const auto put = [&output](T & item) {
+      if (CONSTRUCT) {
+        ::new (static_cast<void *>(output)) T(std::move(item));
+      } else {
+        *output = std::move(item);
+      }
+      ++output;
+    };
+    while (a_last != a && b_last != b) {
+      if (*b < *a) {
+        put(*b++);
+      } else {
+        put(*a++);
+      }
+    }
+    for (; a_last != a; ++a) { put(*a); }
+    for (; b_last != b; ++b) { put(*b); }
+  }
+};
+
+/*
+ * Adaptive Mergesort
+ * ------------------
+ * TimSort: scans natural runs, reversing strictly descending ones and
+ * extending short ones to min_run with binary insertion sort. runs are
+ * pushed on a stack and merged while the lengths on top break
+ * L[n - 2] > L[n - 1] + L[n] and L[n - 1] > L[n], which keeps merges
+ * balanced. a merge first trims what is already in place by galloping,
+ * buffers the shorter run and switches to galloping mode when one side
+ * keeps winning. sorted or reversed input costs n - 1 comparisons.
+ * stable.
+ */
+template <typename T>
+class AdaptiveMergesort {
+public:
+  using size = std::size_t;
+
+  void operator()(T * array, const size length) {
+    MergeBuffer<T> buffer;
+    operator()(array, length, buffer);
+  }
+
+  void operator()(T * array, const size length, MergeBuffer<T> & buffer) {
+    if (2 > length) {
+      return;
+    }
+    array_ = array;
+    buffer_ = &buffer;
+    min_gallop_ = MIN_GALLOP;
+    stack_.clear();
+    const size minimum = min_run(length);
+    for (size low = 0; length > low;) {
+      size run = count_run(low, length);
+      if (minimum > run) {
+        const size forced = std::min(minimum, length - low);
+        binary_insertion_sort(low, low + forced, low + run);
+        run = forced;
+      }
+      stack_.push_back(Run{low, run});
+      merge_collapse();
+      low += run;
+    }
+    while (1 < stack_.size()) {
+      size n = stack_.size() - 2;
+      if (0 < n && stack_[n - 1].length < stack_[n + 1].length) {
+        --n;
+      }
+      merge_at(n);
+    }
+    array_ = nullptr;
+    buffer_ = nullptr;
+  }
+
+private:
+  static constexpr size MIN_GALLOP = 7;
+
+  struct Run {
+    size base;
+    size length;
+  };
+
+  /* between 32 and 64, so length / min_run is a power of two or just below */
+  static size min_run(size length) {
+    size r = 0;
+    while (64 <= length) {
+      r |= length & 1;
+      length >>= 1;
+    }
+    return length + r;
+  }
+
+  /* length of the run starting at low, strictly descending runs are reversed */
+  size count_run(const size low, const size high) {
+    size i = low + 1;
+    if (high == i) {
+      return 1;
+    }
+    if (array_[i] < array_[low]) {
+      for (++i; high > i && array_[i] < array_[i - 1]; ++i) { }
+      std::reverse(array_ + low, array_ + i);
+    } else {
+      for (++i; high > i && ! (array_[i] < array_[i - 1]); ++i) { }
+    }
+    return i - low;
+  }
+
+  /* [low, start) is sorted already */
+  void binary_insertion_sort(const size low, const size high, size start) {
+    for (; high > start; ++start) {
+      T item{std::move(array_[start])};
+      const T * position = std::upper_bound(array_ + low, array_ + start, item);
+      T * const hole = array_ + (position - array_);
+      std::move_backward(hole, array_ + start, array_ + start + 1);
+      *hole = std::move(item);
+    }
+  }
+
+  void merge_collapse() {
+    while (1 < stack_.size()) {
+      size n = stack_.size() - 2;
+      if ((0 < n && stack_[n - 1].length <= stack_[n].length + stack_[n + 1].length)
+          || (1 < n && stack_[n - 2].length <= stack_[n - 1].length + stack_[n].length)) {
+        if (stack_[n - 1].length < stack_[n + 1].length) {
+          --n;
+        }
+      } else if (stack_[n].length > stack_[n + 1].length) {
+        break;
+      }
+      merge_at(n);
+    }
+  }
+
+  /*
+   * exponential search from hint, then binary search, for the number of
+   * elements of a that go before key: those less than key when LEFT,
+   * those less than or equal to key otherwise.
+   */
+  template<bool LEFT>
+  static size gallop(const T & key, const T * a, const size n, const size hint) {
+    const auto before = [&key](const T & item) { return LEFT ? item < key : ! (key < item); };
+    size low, high, last = 0, offset = 1;
+    if (before(a[hint])) {
+      const size maximum = n - hint;
+      while (maximum > offset && before(a[hint + offset])) {
+        last = offset;
+        offset = (offset << 1) + 1;
+      }
+      offset = std::min(offset, maximum);
+      low = hint + last + 1;
+      high = hint + offset;
+    } else {
+      const size maximum = hint + 1;
+      while (maximum > offset && ! before(a[hint - offset])) {
+        last = offset;
+        offset = (offset << 1) + 1;
+      }
+      offset = std::min(offset, maximum);
+      low = hint + 1 - offset;
+      high = hint - last;
+    }
+    while (low < high) {
+      const size middle = low + (high - low) / 2;
+      if (before(a[middle])) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    return low;
+  }
+
+  void merge_at(const size i) {
+    Run a = stack_[i];
+    Run b = stack_[i + 1];
+    stack_[i].length += b.length;
+    stack_.erase(stack_.begin() + i + 1);
+
+    /* a's prefix not greater than b's head and b's suffix not less than a's tail are in place */
+    const size k = gallop<false>(array_[b.base], array_ + a.base, a.length, 0);
+    a.base += k;
+    a.length -= k;
+    if (0 == a.length) {
+      return;
+    }
+    b.length = gallop<true>(array_[a.base + a.length - 1], array_ + b.base, b.length, b.length - 1);
+    if (0 == b.length) {
+      return;
+    }
+    if (a.length <= b.length) {
+      merge_low(a, b);
+    } else {
+      merge_high(a, b);
+    }
+  }
+
+  /* a is shorter and goes to the buffer, merges front to back */
+  void merge_low(const Run a, const Run b) {
+    buffer_->reserve(a.length);
+    T * const buffer = buffer_->data();
+    std::uninitialized_move(array_ + a.base, array_ + a.base + a.length, buffer);
+    T * first = buffer, * second = array_ + b.base, * destination = array_ + a.base;
+    size na = a.length, nb = b.length;
+
+    while (0 < na && 0 < nb) {
+      size count_a = 0, count_b = 0;
+      do {
+        if (*second < *first) {
+          *destination++ = std::move(*second++);
+          --nb;
+          ++count_b;
+          count_a = 0;
+        } else {
+          *destination++ = std::move(*first++);
+          --na;
+          ++count_a;
+          count_b = 0;
+        }
+      } while (0 < na && 0 < nb && min_gallop_ > (count_a | count_b));
+
+      while (0 < na && 0 < nb) {
+        count_a = gallop<false>(*second, first, na, 0);
+        destination = std::move(first, first + count_a, destination);
+        first += count_a;
+        na -= count_a;
+        if (0 == na) {
+          break;
+        }
+        *destination++ = std::move(*second++);
+        if (0 == --nb) {
+          break;
+        }
+        count_b = gallop<true>(*first, second, nb, 0);
+        destination = std::move(second, second + count_b, destination);
+        second += count_b;
+        nb -= count_b;
+        if (0 == nb) {
+          break;
+        }
+        *destination++ = std::move(*first++);
+        if (0 == --na) {
+          break;
+        }
+        min_gallop_ -= 1 < min_gallop_;
+        if (MIN_GALLOP > count_a && MIN_GALLOP > count_b) {
+          break;
+        }
+      }
+      min_gallop_ += 2;
+    }
+    std::move(first, first + na, destination);
+    std::destroy(buffer, buffer + a.length);
+  }
+
+  /* b is shorter and goes to the buffer, merges back to front */
+  void merge_high(const Run a, const Run b) {
+    buffer_->reserve(b.length);
+    T * const buffer = buffer_->data();
+    std::uninitialized_move(array_ + b.base, array_ + b.base + b.length, buffer);
+    T * const first = array_ + a.base;
+    T * destination = array_ + b.base + b.length;
+    size na = a.length, nb = b.length;
+
+    /* the next elements to place are first[na - 1] and buffer[nb - 1] */
+    while (0 < na && 0 < nb) {
+      size count_a = 0, count_b = 0;
+      do {
+        if (buffer[nb - 1] < first[na - 1]) {
+          *--destination = std::move(first[--na]);
+          ++count_a;
+          count_b = 0;
+        } else {
+          *--destination = std::move(buffer[--nb]);
+          ++count_b;
+          count_a = 0;
+        }
+      } while (0 < na && 0 < nb && min_gallop_ > (count_a | count_b));
+
+      while (0 < na && 0 < nb) {
+        count_a = na - gallop<false>(buffer[nb - 1], first, na, na - 1);
+        destination = std::move_backward(first + na - count_a, first + na, destination);
+        na -= count_a;
+        if (0 == na) {
+          break;
+        }
+        *--destination = std::move(buffer[--nb]);
+        if (0 == nb) {
+          break;
+        }
+        count_b = nb - gallop<true>(first[na - 1], buffer, nb, nb - 1);
+        destination = std::move_backward(buffer + nb - count_b, buffer + nb, destination);
+        nb -= count_b;
+        if (0 == nb) {
+          break;
+        }
+        *--destination = std::move(first[--na]);
+        if (0 == na) {
+          break;
+        }
+        min_gallop_ -= 1 < min_gallop_;
+        if (MIN_GALLOP > count_a && MIN_GALLOP > count_b) {
+          break;
+        }
+      }
+      min_gallop_ += 2;
+    }
+    std::move_backward(buffer, buffer + nb, destination);
+    std::destroy(buffer, buffer + b.length);
+  }
+
+  T * array_ = nullptr;
+  MergeBuffer<T> * buffer_ = nullptr;
+  size min_gallop_ = MIN_GALLOP;
+  std::vector<Run> stack_;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-Stealing Task Pool
+ * -----------------------
+ * one deque per thread, the owner pushes and pops at the back (newest,
+ * hottest in cache) while idle threads steal from the front of others
+ * (oldest, the biggest pieces of a fork-join recursion).
+ *
+ * the pool has threads - 1 workers, the thread calling wait is the last
+ * one and runs tasks while it waits, so nested fork-join never blocks.
+ * idle workers spin with yield, keep a pool alive only while sorting.
+ */
+class TaskPool {
+public:
+  using size = std::size_t;
+  using Task = std::function<void()>;
+
+  /* counts the tasks spawned into it that are still running */
+  struct Group {
+    std::atomic<size> pending{0};
+  };
+
+  explicit TaskPool(const size threads = std::thread::hardware_concurrency()) :
+    queues_(std::max<size>(1, threads)) {
+    for (size i = 1; queues_.size() > i; ++i) {
+      workers_.emplace_back([this, i]() {
+        worker() = Worker{this, i};
+        while ( ! stop_.load(std::memory_order_acquire)) {
+          if ( ! run_one()) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+  }
+
+  ~TaskPool() {
+    stop_.store(true, std::memory_order_release);
+    for (auto & worker : workers_) {
+      worker.join();
+    }
+  }
+
+  TaskPool(const TaskPool &) = delete;
+  TaskPool & operator = (const TaskPool &) = delete;
+
+  size threads() const { return queues_.size(); }
+
+  template<class F>
+  void spawn(Group & group, F && f) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    Queue & queue = queues_[index()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.emplace_back([&group, f = std::forward<F>(f)]() {
+      f();
+      group.pending.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  void wait(Group & group) {
+    while (0 < group.pending.load(std::memory_order_acquire)) {
+      if ( ! run_one()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  /* the pool a thread works for and its queue there */
+  struct Worker {
+    const TaskPool * pool;
+    size index;
+  };
+
+  static Worker & worker() {
+    thread_local Worker worker{nullptr, 0};
+    return worker;
+  }
+
+  /* threads outside the pool, workers of other pools too, share queue 0 */
+  size index() const {
+    const Worker & self = worker();
+    return this == self.pool ? self.index : 0;
+  }
+
+  bool run_one() {
+    Task task;
+    const size self = index();
+    {
+      Queue & queue = queues_[self];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if ( ! queue.tasks.empty()) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      }
+    }
+    for (size i = 1; ! task && queues_.size() > i; ++i) {
+      Queue & victim = queues_[(self + i) % queues_.size()];
+      std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+      if (lock.owns_lock() && ! victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+      }
+    }
+    if (task) {
+      task();
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<bool> stop_{false};
+};
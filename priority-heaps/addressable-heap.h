@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+/*
+ * min-heap like PriorityHeap whose push returns a handle that stays
+ * valid until the element is popped or erased, handles are recycled
+ * after that. position_ is a side array from handle to heap index, so
+ * update and erase are O(log n) without allocating per element.
+ */
+template<typename T, std::size_t ARITY = 2>
+struct AddressablePriorityHeap {
+  static_assert(2 == ARITY || 4 == ARITY || 8 == ARITY, "arity must be 2, 4 or 8");
+  using size = std::size_t;
+  using Handle = std::size_t;
+  static constexpr size NONE = std::numeric_limits<size>::max();
+
+  template<class ... ARGS>
+  Handle push(ARGS && ... args) {
+    Handle handle;
+    if (free_.empty()) {
+      handle = position_.size();
+      position_.push_back(NONE);
+    } else {
+      handle = free_.back();
+      free_.pop_back();
+    }
+    container_.push_back(Entry{T(std::forward<ARGS>(args)...), handle});
+    sift_up(container_.size() - 1);
+    return handle;
+  }
+
+  T pop() {
+    assert( ! container_.empty());
+    T result{std::move(container_[0].value)};
+    remove(0);
+    return result;
+  }
+
+  /* replaces the element behind handle, it can move either way */
+  void update(const Handle handle, T value) {
+    assert(contains(handle));
+    const size i = position_[handle];
+    const bool up = container_[i].value > value;
+    container_[i].value = std::move(value);
+    if (up) {
+      sift_up(i);
+    } else {
+      sift_down(i);
+    }
+  }
+
+  void erase(const Handle handle) {
+    assert(contains(handle));
+    remove(position_[handle]);
+  }
+
+  bool contains(const Handle handle) const {
+    return position_.size() > handle && NONE != position_[handle];
+  }
+
+  const T & get(const Handle handle) const { return container_[position_[handle]].value; }
+  const T & top() const { return container_[0].value; }
+  bool empty() const { return container_.empty(); }
+  size length() const { return container_.size(); }
+
+private:
+  struct Entry {
+    T value;
+    Handle handle;
+  };
+
+  void remove(const size i) {
+    position_[container_[i].handle] = NONE;
+    free_.push_back(container_[i].handle);
+    Entry last{std::move(container_.back())};
+    container_.pop_back();
+    if (container_.size() > i) {
+      const bool up = 0 < i && container_[(i - 1) / ARITY].value > last.value;
+      container_[i] = std::move(last);
+      if (up) {
+        sift_up(i);
+      } else {
+        sift_down(i);
+      }
+    }
+  }
+
+  void place(const size i, Entry && entry) {
+    position_[entry.handle] = i;
+    container_[i] = std::move(entry);
+  }
+
+  void sift_up(size i) {
+    Entry entry{std::move(container_[i])};
+    while (0 < i) {
+      const size parent = (i - 1) / ARITY;
+      if ( ! (container_[parent].value > entry.value)) {
+        break;
+      }
+      place(i, std::move(container_[parent]));
+      i = parent;
+    }
+    place(i, std::move(entry));
+  }
+
+  void sift_down(size i) {
+    Entry entry{std::move(container_[i])};
+    const size length = container_.size();
+    while (true) {
+      const size first = ARITY * i + 1;
+      if (length <= first) {
+        break;
+      }
+      const size last = std::min(first + ARITY, length);
+      size smallest = first;
+      for (size child = first + 1; last > child; ++child) {
+        if (container_[smallest].value > container_[child].value) {
+          smallest = child;
+        }
+      }
+      if ( ! (entry.value > container_[smallest].value)) {
+        break;
+      }
+      place(i, std::move(container_[smallest]));
+      i = smallest;
+    }
+    place(i, std::move(entry));
+  }
+
+  std::vector<Entry> container_;
+  std::vector<size> position_; /* handle -> index in container_ */
+  std::vector<Handle> free_;
+};
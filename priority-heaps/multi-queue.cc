@@ -0,0 +1,104 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cassert>
+
+#include "multi-queue.h"
+
+/*
+ * every thread alternates push and pop on a queue prefilled with
+ * prefill elements, reports million operations per second.
+ */
+double throughput(const std::size_t threads, const std::size_t prefill, const std::size_t operations) {
+  MultiQueue<std::uint64_t> queue(threads);
+  {
+    std::mt19937_64 generator(prefill);
+    for (std::size_t i = 0; prefill > i; ++i) {
+      queue.push(generator());
+    }
+  }
+  std::atomic<bool> go{false};
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; threads > t; ++t) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 generator(t);
+      while ( ! go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (std::size_t i = 0; operations / threads > i; i += 2) {
+        queue.push(generator());
+        queue.pop();
+      }
+    });
+  }
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return operations / seconds / 1e6;
+}
+
+/*
+ * fills the queue with 0 ... size - 1 and drains it from all threads.
+ * pops are ordered by a global ticket taken right after each pop, the
+ * rank error of a pop is how many smaller elements were still queued.
+ * a fenwick tree over the values counts those.
+ */
+double rank_error(const std::size_t threads, const std::size_t size) {
+  MultiQueue<std::size_t> queue(threads);
+  for (std::size_t i = 0; size > i; ++i) {
+    queue.push(i);
+  }
+  std::vector<std::size_t> popped(size);
+  std::atomic<std::size_t> ticket{0};
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; threads > t; ++t) {
+    workers.emplace_back([&]() {
+      while (auto item = queue.pop()) {
+        popped[ticket.fetch_add(1, std::memory_order_relaxed)] = *item;
+      }
+    });
+  }
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  assert(size == ticket.load());
+
+  std::vector<std::size_t> tree(size + 1, 0);
+  const auto add = [&](std::size_t i, const std::size_t delta) {
+    for (++i; size >= i; i += i & -i) { tree[i] += delta; }
+  };
+  const auto prefix = [&](std::size_t i) {
+    std::size_t sum = 0;
+    for (; 0 < i; i -= i & -i) { sum += tree[i]; }
+    return sum;
+  };
+  for (std::size_t i = 0; size > i; ++i) {
+    add(i, 1);
+  }
+  double total = 0;
+  for (const std::size_t item : popped) {
+    total += prefix(item);
+    add(item, -1);
+  }
+  return total / size;
+}
+
+int main(int argc, char * * argv) {
+  const std::size_t max_threads = 1 < argc ? std::stoul(argv[1]) : 64;
+  const std::size_t operations = 2 < argc ? std::stoul(argv[2]) : 1 << 22;
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+  std::cout << "threads, Mops/s, mean rank error" << std::endl;
+  for (std::size_t threads = 1; max_threads >= threads; threads *= 2) {
+    std::cout << threads << ", " << throughput(threads, 1 << 20, operations)
+      << ", " << rank_error(threads, 1 << 20) << std::endl;
+  }
+  return 0;
+}
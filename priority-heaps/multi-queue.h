@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "priority-heap.h"
+
+/*
+ * MultiQueue
+ * ----------
+ * relaxed concurrent min-priority queue: C * threads independent
+ * PriorityHeaps, each behind its own lock. push goes into a random heap,
+ * pop peeks two random heaps and takes the smaller top (two-choice).
+ *
+ * pops are not exact, the element returned is close to the minimum with
+ * an expected rank error of O(threads). pop only returns an empty
+ * optional after finding every heap empty.
+ */
+template<typename T, std::size_t ARITY = 4>
+struct MultiQueue {
+  using size = std::size_t;
+
+  explicit MultiQueue(const size threads, const size factor = 2) :
+    queues_(std::max<size>(2, factor * threads)) { }
+
+  template<class ... ARGS>
+  void push(ARGS && ... args) {
+    while (true) {
+      Queue & queue = queues_[random() % queues_.size()];
+      std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+      if (lock.owns_lock()) {
+        queue.heap.push(std::forward<ARGS>(args)...);
+        return;
+      }
+    }
+  }
+
+  std::optional<T> pop() {
+    const size length = queues_.size();
+    for (size attempt = 0; length > attempt; ++attempt) {
+      const size a = random() % length;
+      size b = random() % (length - 1);
+      b += a <= b;
+      std::unique_lock<std::mutex> lock_a(queues_[a].mutex, std::try_to_lock);
+      if ( ! lock_a.owns_lock()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock_b(queues_[b].mutex, std::try_to_lock);
+      Queue * queue = &queues_[a];
+      if (lock_b.owns_lock() && ! queues_[b].heap.empty()
+          && (queue->heap.empty() || queue->heap.top() > queues_[b].heap.top())) {
+        queue = &queues_[b];
+      }
+      if ( ! queue->heap.empty()) {
+        return queue->heap.pop();
+      }
+    }
+    /* two-choice kept missing, sweep everything before declaring empty */
+    for (Queue & queue : queues_) {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if ( ! queue.heap.empty()) {
+        return queue.heap.pop();
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  /* one cache line each, so neighbouring locks do not false share */
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    PriorityHeap<T, ARITY> heap;
+  };
+
+  static size random() {
+    thread_local std::minstd_rand generator(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return generator();
+  }
+
+  std::vector<Queue> queues_;
+};
@@ -1,44 +1,164 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <string>
 #include <vector>
 
-template<typename T>
-struct PriorityHeap {
-  using size = std::size_t;
-  std::vector<T> container_;
-
-  template<class ... ARGS>
-  void push(ARGS && ... args) {
-    container_.emplace_back(std::forward<ARGS>(args)...);
-    size i = container_.size() - 1;
-    while (0 < i) {
-      const size half = i / 2;
-      if (container_[half] > container_[i]) {
-        std::swap(container_[half], container_[i]);
-        i = half;
-      } else {
-        return;
+#include <cassert>
+
+#include "addressable-heap.h"
+#include "priority-heap.h"
+#include "radix-heap.h"
+
+template<class HEAP>
+double benchmark(const std::vector<int> & input, std::vector<int> & output, HEAP & heap) {
+  const auto start = std::chrono::steady_clock::now();
+  for (const int item : input) {
+    heap.push(item);
+  }
+  for (auto & item : output) {
+    item = heap.pop();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* std::priority_queue does not return from pop */
+struct StdPriorityQueue {
+  std::priority_queue<int, std::vector<int>, std::greater<int>> queue_;
+  void push(const int item) { queue_.push(item); }
+  int pop() {
+    const int result = queue_.top();
+    queue_.pop();
+    return result;
+  }
+};
+
+void benchmark(const std::size_t size) {
+  std::vector<int> input(size), output(size);
+  std::mt19937 generator(size);
+  for (auto & item : input) {
+    item = generator();
+  }
+
+  const auto run = [&](const char * name, auto && heap) {
+    const double seconds = benchmark(input, output, heap);
+    assert(std::is_sorted(output.begin(), output.end()));
+    std::cout << name << ": " << seconds << "s" << std::endl;
+  };
+
+  std::cout << size << " pushes followed by as many pops" << std::endl;
+  run("std::priority_queue", StdPriorityQueue());
+  run("PriorityHeap<int, 2>", PriorityHeap<int, 2>());
+  run("PriorityHeap<int, 4>", PriorityHeap<int, 4>());
+  run("PriorityHeap<int, 8>", PriorityHeap<int, 8>());
+}
+
+/*
+ * single source shortest paths on a random graph three ways: pushing
+ * duplicates into PriorityHeap, updating in place through handles and
+ * with a RadixHeap, the distances must match.
+ */
+void dijkstra(const std::size_t vertices, const std::size_t edges) {
+  using Distance = std::uint64_t;
+  using Distances = std::vector<Distance>;
+  using Pair = std::pair<Distance, std::size_t>;
+  constexpr Distance INFINITE = std::numeric_limits<Distance>::max();
+  struct Edge { std::size_t to; Distance weight; };
+  std::vector<std::vector<Edge>> graph(vertices);
+  std::mt19937_64 generator(vertices);
+  for (std::size_t i = 0; edges > i; ++i) {
+    graph[generator() % vertices].push_back(Edge{generator() % vertices, 1 + generator() % 1000});
+  }
+
+  const auto time = [](const char * name, auto && function) {
+    const auto start = std::chrono::steady_clock::now();
+    Distances distances = function();
+    std::cout << name << ": " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+    return distances;
+  };
+
+  const Distances a = time("PriorityHeap with duplicates", [&]() {
+    Distances distances(vertices, INFINITE);
+    PriorityHeap<Pair, 4> heap;
+    distances[0] = 0;
+    heap.push(0, 0);
+    while ( ! heap.empty()) {
+      const auto [distance, vertex] = heap.pop();
+      if (distances[vertex] < distance) {
+        continue;
+      }
+      for (const Edge & edge : graph[vertex]) {
+        if (distances[edge.to] > distance + edge.weight) {
+          distances[edge.to] = distance + edge.weight;
+          heap.push(distances[edge.to], edge.to);
+        }
       }
     }
-  }
+    return distances;
+  });
 
-  T pop() {
-    T result{std::move(container_[0])};
-    size parent = 1, i = 2;
-    while (container_.size() >= i) {
-      if (container_.size() > i && container_[i - 1] > container_[i]) {
-        i = 1 + i;
+  const Distances b = time("AddressablePriorityHeap", [&]() {
+    using Heap = AddressablePriorityHeap<Pair, 4>;
+    Distances distances(vertices, INFINITE);
+    std::vector<Heap::Handle> handles(vertices, Heap::NONE);
+    Heap heap;
+    distances[0] = 0;
+    handles[0] = heap.push(0, 0);
+    while ( ! heap.empty()) {
+      const auto [distance, vertex] = heap.pop();
+      handles[vertex] = Heap::NONE;
+      for (const Edge & edge : graph[vertex]) {
+        if (distances[edge.to] > distance + edge.weight) {
+          distances[edge.to] = distance + edge.weight;
+          if (Heap::NONE == handles[edge.to]) {
+            handles[edge.to] = heap.push(distances[edge.to], edge.to);
+          } else {
+            heap.update(handles[edge.to], Pair{distances[edge.to], edge.to});
+          }
+        }
       }
-      std::swap(container_[parent - 1], container_[i - 1]);
-      parent = i;
-      i *= 2;
     }
-    std::swap(container_[parent - 1], container_[container_.size() - 1]);
-    container_.pop_back();
-    return result;
+    return distances;
+  });
+
+  const Distances c = time("RadixHeap", [&]() {
+    Distances distances(vertices, INFINITE);
+    RadixHeap<Distance, std::size_t> heap;
+    distances[0] = 0;
+    heap.push(0, 0);
+    while ( ! heap.empty()) {
+      const auto [distance, vertex] = heap.pop();
+      if (distances[vertex] < distance) {
+        continue;
+      }
+      for (const Edge & edge : graph[vertex]) {
+        if (distances[edge.to] > distance + edge.weight) {
+          distances[edge.to] = distance + edge.weight;
+          heap.push(distances[edge.to], edge.to);
+        }
+      }
+    }
+    return distances;
+  });
+
+  assert(a == b && a == c);
+}
+
+int main(int argc, char * * argv) {
+  if (2 < argc && std::string("benchmark") == argv[1]) {
+    benchmark(std::stoul(argv[2]));
+    return 0;
+  }
+
+  if (3 < argc && std::string("dijkstra") == argv[1]) {
+    dijkstra(std::stoul(argv[2]), std::stoul(argv[3]));
+    return 0;
   }
-};
 
-int main() {
   PriorityHeap<int> priority_heap;
   for (int i = 9; 0 <= i; --i) {
     priority_heap.push(i);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+/*
+ * min-heap where every node has ARITY children: the children of i are
+ * ARITY * i + 1 ... ARITY * i + ARITY, its parent is (i - 1) / ARITY.
+ * wider nodes make the tree shallower and keep siblings on the same
+ * cache line, which pays off on pop for large heaps.
+ *
+ * sifting moves elements into a hole instead of swapping at every step.
+ */
+template<typename T, std::size_t ARITY = 2>
+struct PriorityHeap {
+  static_assert(2 == ARITY || 4 == ARITY || 8 == ARITY, "arity must be 2, 4 or 8");
+  using size = std::size_t;
+  std::vector<T> container_;
+
+  template<class ... ARGS>
+  void push(ARGS && ... args) {
+    container_.emplace_back(std::forward<ARGS>(args)...);
+    sift_up(container_.size() - 1);
+  }
+
+  T pop() {
+    assert( ! container_.empty());
+    T result{std::move(container_[0])};
+    T last{std::move(container_.back())};
+    container_.pop_back();
+    if ( ! container_.empty()) {
+      sift_down(0, std::move(last));
+    }
+    return result;
+  }
+
+  /* pop and push in one sift, for heaps of a bounded length */
+  T replace(T item) {
+    assert( ! container_.empty());
+    T result{std::move(container_[0])};
+    sift_down(0, std::move(item));
+    return result;
+  }
+
+  const T & top() const { return container_[0]; }
+  bool empty() const { return container_.empty(); }
+  size length() const { return container_.size(); }
+
+private:
+  void sift_up(size i) {
+    T element{std::move(container_[i])};
+    while (0 < i) {
+      const size parent = (i - 1) / ARITY;
+      if ( ! (container_[parent] > element)) {
+        break;
+      }
+      container_[i] = std::move(container_[parent]);
+      i = parent;
+    }
+    container_[i] = std::move(element);
+  }
+
+  /* i is a hole, element is what would go there */
+  void sift_down(size i, T && element) {
+    const size length = container_.size();
+    while (true) {
+      const size first = ARITY * i + 1;
+      if (length <= first) {
+        break;
+      }
+      const size last = std::min(first + ARITY, length);
+      size smallest = first;
+      for (size child = first + 1; last > child; ++child) {
+        if (container_[smallest] > container_[child]) {
+          smallest = child;
+        }
+      }
+      if ( ! (element > container_[smallest])) {
+        break;
+      }
+      container_[i] = std::move(container_[smallest]);
+      i = smallest;
+    }
+    container_[i] = std::move(element);
+  }
+};
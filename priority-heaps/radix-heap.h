@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+/*
+ * Radix Heap
+ * ----------
+ * min-heap for monotone unsigned integer keys: every pushed key must be
+ * greater than or equal to the last popped one, which holds for
+ * Dijkstra and for timers. bucket b holds the keys whose highest bit
+ * that differs from last_ is b - 1, bucket 0 holds keys equal to last_.
+ * pop only redistributes a bucket when bucket 0 runs dry, each key moves
+ * to a lower bucket at most once per bit, so push and pop are amortized
+ * O(log C) with no comparisons between elements.
+ */
+template<typename KEY, typename VALUE>
+struct RadixHeap {
+  static_assert(std::is_unsigned<KEY>::value, "keys must be unsigned integers");
+  using size = std::size_t;
+  using Pair = std::pair<KEY, VALUE>;
+  static constexpr size BITS = std::numeric_limits<KEY>::digits;
+
+  template<class ... ARGS>
+  void push(const KEY key, ARGS && ... args) {
+    assert(last_ <= key);
+    buckets_[bucket(key)].emplace_back(std::piecewise_construct,
+        std::forward_as_tuple(key), std::forward_as_tuple(std::forward<ARGS>(args)...));
+    ++length_;
+  }
+
+  Pair pop() {
+    assert(0 < length_);
+    if (buckets_[0].empty()) {
+      size b = 1;
+      while (buckets_[b].empty()) {
+        ++b;
+      }
+      KEY minimum = buckets_[b][0].first;
+      for (const Pair & pair : buckets_[b]) {
+        minimum = std::min(minimum, pair.first);
+      }
+      last_ = minimum;
+      for (Pair & pair : buckets_[b]) {
+        buckets_[bucket(pair.first)].push_back(std::move(pair));
+      }
+      buckets_[b].clear();
+    }
+    Pair result{std::move(buckets_[0].back())};
+    buckets_[0].pop_back();
+    --length_;
+    return result;
+  }
+
+  bool empty() const { return 0 == length_; }
+  size length() const { return length_; }
+
+private:
+  size bucket(const KEY key) const {
+    const unsigned long long difference = key ^ last_;
+    return 0 == difference ? 0 : std::numeric_limits<unsigned long long>::digits - __builtin_clzll(difference);
+  }
+
+  std::array<std::vector<Pair>, BITS + 1> buckets_;
+  KEY last_ = 0;
+  size length_ = 0;
+};
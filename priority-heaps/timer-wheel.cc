@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <cassert>
+
+#include "addressable-heap.h"
+#include "priority-heap.h"
+#include "timer-wheel.h"
+
+/*
+ * connection timeouts: connections live timers, each tick activity
+ * resets the timeout of some random connections (cancel + schedule) and
+ * expired connections are replaced by new ones. almost no timer fires.
+ * every engine is fed the same random sequence and reschedules expired
+ * connections independently of firing order, so the number of
+ * expirations must match.
+ */
+struct Workload {
+  std::size_t connections;
+  std::size_t ticks;
+  std::size_t activity; /* resets per tick */
+  std::uint64_t timeout;
+};
+
+struct Result {
+  double seconds;
+  std::size_t fired;
+};
+
+template<class ENGINE>
+Result run(const Workload & workload) {
+  ENGINE engine;
+  std::mt19937_64 generator(workload.connections);
+  const auto jitter = [&]() { return workload.timeout + generator() % (workload.timeout / 4); };
+  std::size_t fired = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; workload.connections > i; ++i) {
+    engine.schedule(i, jitter());
+  }
+  for (std::uint64_t now = 1; workload.ticks >= now; ++now) {
+    for (std::size_t i = 0; workload.activity > i; ++i) {
+      engine.reset(generator() % workload.connections, now + jitter());
+    }
+    fired += engine.expire(now, [&](const std::size_t connection) {
+      engine.schedule(connection, now + workload.timeout + (connection * 2654435761u + now) % (workload.timeout / 4));
+    });
+  }
+  return Result{std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), fired};
+}
+
+struct WheelEngine {
+  using Wheel = TimerWheel<std::size_t>;
+  Wheel wheel_;
+  std::vector<Wheel::Handle> handles_;
+
+  void schedule(const std::size_t connection, const std::uint64_t deadline) {
+    if (handles_.size() <= connection) {
+      handles_.resize(connection + 1);
+    }
+    handles_[connection] = wheel_.schedule(deadline, connection);
+  }
+  void reset(const std::size_t connection, const std::uint64_t deadline) {
+    wheel_.cancel(handles_[connection]);
+    schedule(connection, deadline);
+  }
+  template<class CALLBACK>
+  std::size_t expire(const std::uint64_t now, CALLBACK && callback) {
+    return wheel_.advance(now, callback);
+  }
+};
+
+/* PriorityHeap cannot cancel, stale entries are skipped by version */
+struct HeapEngine {
+  PriorityHeap<std::tuple<std::uint64_t, std::size_t, std::uint32_t>, 4> heap_;
+  std::vector<std::uint32_t> versions_;
+
+  void schedule(const std::size_t connection, const std::uint64_t deadline) {
+    if (versions_.size() <= connection) {
+      versions_.resize(connection + 1);
+    }
+    heap_.push(deadline, connection, ++versions_[connection]);
+  }
+  void reset(const std::size_t connection, const std::uint64_t deadline) {
+    schedule(connection, deadline);
+  }
+  template<class CALLBACK>
+  std::size_t expire(const std::uint64_t now, CALLBACK && callback) {
+    std::size_t fired = 0;
+    while ( ! heap_.empty() && now >= std::get<0>(heap_.top())) {
+      const auto [deadline, connection, version] = heap_.pop();
+      if (version == versions_[connection]) {
+        ++fired;
+        callback(connection);
+      }
+    }
+    return fired;
+  }
+};
+
+struct AddressableEngine {
+  using Heap = AddressablePriorityHeap<std::pair<std::uint64_t, std::size_t>, 4>;
+  Heap heap_;
+  std::vector<Heap::Handle> handles_;
+
+  void schedule(const std::size_t connection, const std::uint64_t deadline) {
+    if (handles_.size() <= connection) {
+      handles_.resize(connection + 1);
+    }
+    handles_[connection] = heap_.push(deadline, connection);
+  }
+  void reset(const std::size_t connection, const std::uint64_t deadline) {
+    heap_.update(handles_[connection], {deadline, connection});
+  }
+  template<class CALLBACK>
+  std::size_t expire(const std::uint64_t now, CALLBACK && callback) {
+    std::size_t fired = 0;
+    while ( ! heap_.empty() && now >= heap_.top().first) {
+      const std::size_t connection = heap_.pop().second;
+      ++fired;
+      callback(connection);
+    }
+    return fired;
+  }
+};
+
+int main(int argc, char * * argv) {
+  Workload workload{1000000, 20000, 1000, 10000};
+  if (1 < argc) { workload.connections = std::stoul(argv[1]); }
+  if (2 < argc) { workload.ticks = std::stoul(argv[2]); }
+  if (3 < argc) { workload.activity = std::stoul(argv[3]); }
+  if (4 < argc) { workload.timeout = std::stoul(argv[4]); }
+  std::cout << workload.connections << " connections, " << workload.ticks << " ticks, "
+    << workload.activity << " resets per tick, timeout " << workload.timeout << " ticks" << std::endl;
+
+  const Result wheel = run<WheelEngine>(workload);
+  std::cout << "TimerWheel: " << wheel.seconds << "s, " << wheel.fired << " fired" << std::endl;
+  const Result heap = run<HeapEngine>(workload);
+  std::cout << "PriorityHeap (lazy cancel): " << heap.seconds << "s, " << heap.fired << " fired" << std::endl;
+  const Result addressable = run<AddressableEngine>(workload);
+  std::cout << "AddressablePriorityHeap: " << addressable.seconds << "s, " << addressable.fired << " fired" << std::endl;
+  assert(wheel.fired == heap.fired && wheel.fired == addressable.fired);
+  return 0;
+}
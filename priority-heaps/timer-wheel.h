@@ -0,0 +1,210 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+#include "priority-heap.h"
+
+/*
+ * Hierarchical Timing Wheel
+ * -------------------------
+ * LEVELS wheels of 256 slots, level l slot s holds the timers whose
+ * deadline differs from now in the l-th byte (and no higher one), at
+ * digit s. when now crosses into a new level l slot, its timers cascade
+ * down, a timer moves at most LEVELS times in its life. deadlines beyond
+ * the last level wait in a PriorityHeap and are pulled into the wheels
+ * when the top level wraps.
+ *
+ * timers live in a pool linked into their slot by index, schedule and
+ * cancel are O(1), advance fires a whole slot per tick. time is an
+ * abstract tick count, deadlines not in the future fire on the next tick.
+ */
+template<typename VALUE, std::size_t LEVELS = 4>
+struct TimerWheel {
+  static_assert(0 < LEVELS && 8 > LEVELS, "levels must be 1 to 7");
+  using Tick = std::uint64_t;
+  using size = std::size_t;
+
+  struct Handle {
+    std::uint32_t index;
+    std::uint32_t generation;
+  };
+
+  explicit TimerWheel(const Tick now = 0) : now_(now) {
+    for (auto & level : slots_) {
+      level.fill(NIL);
+    }
+  }
+
+  template<class ... ARGS>
+  Handle schedule(Tick deadline, ARGS && ... args) {
+    deadline = std::max(deadline, now_ + 1);
+    std::uint32_t index;
+    if (NIL != free_) {
+      index = free_;
+      free_ = pool_[index].next;
+    } else {
+      index = pool_.size();
+      pool_.emplace_back();
+    }
+    Node & node = pool_[index];
+    node.deadline = deadline;
+    node.value.emplace(std::forward<ARGS>(args)...);
+    place(index);
+    ++length_;
+    return Handle{index, node.generation};
+  }
+
+  /* false if the timer already fired or was cancelled */
+  bool cancel(const Handle handle) {
+    if (pool_.size() <= handle.index) {
+      return false;
+    }
+    Node & node = pool_[handle.index];
+    if (handle.generation != node.generation || ! node.value) {
+      return false;
+    }
+    if (HEAP != node.level) {
+      unlink(handle.index);
+      release(handle.index);
+    } else {
+      /* the heap entry goes stale and is skipped, the node is freed then */
+      node.value.reset();
+      ++node.generation;
+    }
+    --length_;
+    return true;
+  }
+
+  /*
+   * moves time forward to now, calling callback(VALUE &&) for every timer
+   * that expires on the way, in deadline order across ticks.
+   */
+  template<class CALLBACK>
+  size advance(const Tick now, CALLBACK && callback) {
+    size fired = 0;
+    while (now > now_) {
+      ++now_;
+      cascade();
+      std::uint32_t & head = slots_[0][now_ & MASK];
+      while (NIL != head) {
+        const std::uint32_t index = head;
+        head = pool_[index].next;
+        VALUE value{std::move(*pool_[index].value)};
+        release(index);
+        --length_;
+        ++fired;
+        callback(std::move(value));
+      }
+    }
+    return fired;
+  }
+
+  Tick now() const { return now_; }
+  bool empty() const { return 0 == length_; }
+  size length() const { return length_; }
+
+private:
+  static constexpr std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::uint8_t HEAP = LEVELS;
+  static constexpr size BITS = 8;
+  static constexpr Tick MASK = (Tick(1) << BITS) - 1;
+
+  struct Node {
+    Tick deadline = 0;
+    std::uint32_t next = NIL;
+    std::uint32_t previous = NIL;
+    std::uint32_t generation = 0;
+    std::uint8_t level = 0;
+    std::optional<VALUE> value;
+  };
+
+  /* highest byte where deadline and now differ */
+  size level(const Tick deadline) const {
+    const Tick difference = deadline ^ now_;
+    return 0 == difference ? 0 : (std::numeric_limits<Tick>::digits - 1 - __builtin_clzll(difference)) / BITS;
+  }
+
+  void place(const std::uint32_t index) {
+    Node & node = pool_[index];
+    const size l = level(node.deadline);
+    if (LEVELS <= l) {
+      node.level = HEAP;
+      far_.push(node.deadline, index, node.generation);
+      return;
+    }
+    node.level = l;
+    std::uint32_t & head = slots_[l][(node.deadline >> (BITS * l)) & MASK];
+    node.previous = NIL;
+    node.next = head;
+    if (NIL != head) {
+      pool_[head].previous = index;
+    }
+    head = index;
+  }
+
+  void unlink(const std::uint32_t index) {
+    Node & node = pool_[index];
+    if (NIL != node.previous) {
+      pool_[node.previous].next = node.next;
+    } else {
+      slots_[node.level][(node.deadline >> (BITS * node.level)) & MASK] = node.next;
+    }
+    if (NIL != node.next) {
+      pool_[node.next].previous = node.previous;
+    }
+  }
+
+  void release(const std::uint32_t index) {
+    Node & node = pool_[index];
+    node.value.reset();
+    ++node.generation;
+    node.next = free_;
+    free_ = index;
+  }
+
+  /* on a slot boundary, re-places the timers of the slot now entered */
+  void cascade() {
+    size l = 1;
+    while (LEVELS > l && 0 == (now_ & ((Tick(1) << (BITS * l)) - 1))) {
+      ++l;
+    }
+    /* levels [1, l) just rolled over, from the highest one down */
+    if (LEVELS == l && 0 == (now_ & ((Tick(1) << (BITS * LEVELS)) - 1))) {
+      while ( ! far_.empty() && LEVELS > level(std::get<0>(far_.top()))) {
+        const auto [deadline, index, generation] = far_.pop();
+        if (generation == pool_[index].generation) {
+          place(index);
+        } else {
+          /* cancelled while in the heap */
+          pool_[index].next = free_;
+          free_ = index;
+        }
+      }
+    }
+    while (1 < l) {
+      --l;
+      std::uint32_t head = slots_[l][(now_ >> (BITS * l)) & MASK];
+      slots_[l][(now_ >> (BITS * l)) & MASK] = NIL;
+      while (NIL != head) {
+        const std::uint32_t index = head;
+        head = pool_[index].next;
+        place(index);
+      }
+    }
+  }
+
+  Tick now_;
+  size length_ = 0;
+  std::uint32_t free_ = NIL;
+  std::vector<Node> pool_;
+  std::array<std::array<std::uint32_t, 1 << BITS>, LEVELS> slots_;
+  PriorityHeap<std::tuple<Tick, std::uint32_t, std::uint32_t>> far_;
+};
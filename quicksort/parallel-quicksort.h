@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+#include "../mergesort/task-pool.h"
+#include "quicksort.h"
+
+/*
+ * Parallel Quicksort
+ * ------------------
+ * in-place Quicksort on a work-stealing TaskPool. after every partition
+ * the smaller side becomes a task and the same thread loops on the larger
+ * one, until SERIAL elements, which Pdqsort sorts on one thread. above
+ * PARALLEL_PARTITION elements the partition itself runs in parallel:
+ *
+ * 1. every BLOCK of the range is partitioned on its own, counting how
+ *    many of its elements are less than the pivot.
+ * 2. with those counts the range splits at less, the total. elements
+ *    not less than the pivot left of the split and the ones less than
+ *    it right of the split are equally many, the i-th misplaced one on
+ *    the left swaps with the i-th misplaced one on the right, in
+ *    parallel slices.
+ *
+ * every decision depends on sizes and values only, never on the number
+ * of threads or on who steals what, so the output is the same for any
+ * pool, equal keys included.
+ */
+template<typename T>
+class ParallelQuicksort {
+public:
+  using size = std::size_t;
+  static constexpr size SERIAL = 1 << 16;
+  static constexpr size PARALLEL_PARTITION = 1 << 20;
+  static constexpr size BLOCK = 1 << 16;
+
+  explicit ParallelQuicksort(TaskPool & pool) : pool_(pool) { }
+
+  void operator()(T * a, const size length) {
+    if (2 > length) {
+      return;
+    }
+    TaskPool::Group group;
+    sort(group, a, a + length, 2 * static_cast<size>(std::log2(length)));
+    pool_.wait(group);
+  }
+
+private:
+  /* sorts [first, last), spawning into group */
+  void sort(TaskPool::Group & group, T * first, T * last, size depth) {
+    while (SERIAL < static_cast<size>(last - first)) {
+      if (0 == depth--) {
+        Pdqsort<T>()(first, last - first);
+        return;
+      }
+      Introsort<T>::choose_pivot(first, last);
+      const T pivot = *first;
+      T * middle = partition(first, last, [&pivot](const T & item) { return item < pivot; });
+      if (first == middle) {
+        /* the pivot is the minimum, everything equal to it is done */
+        first = partition(first, last, [&pivot](const T & item) { return ! (pivot < item); });
+        continue;
+      }
+      if (middle - first < last - middle) {
+        pool_.spawn(group, [this, &group, first, middle, depth]() { sort(group, first, middle, depth); });
+        first = middle;
+      } else {
+        pool_.spawn(group, [this, &group, middle, last, depth]() { sort(group, middle, last, depth); });
+        last = middle;
+      }
+    }
+    Pdqsort<T>()(first, last - first);
+  }
+
+  /*
+   * branchless Lomuto: [first, store) is less and [store, i) is not, the
+   * element at i always swaps with store, which only advances for less.
+   */
+  template<class LESS>
+  static T * lomuto(T * const first, T * const last, const LESS & less) {
+    T * store = first;
+    for (T * i = first; last != i; ++i) {
+      const bool smaller = less(*i);
+      T item{std::move(*i)};
+      *i = std::move(*store);
+      *store = std::move(item);
+      store += smaller;
+    }
+    return store;
+  }
+
+  /* moves the elements satisfying less to the front, returns where they end */
+  template<class LESS>
+  T * partition(T * const first, T * const last, const LESS & less) {
+    const size length = last - first;
+    if (PARALLEL_PARTITION > length) {
+      return lomuto(first, last, less);
+    }
+
+    const size blocks = (length + BLOCK - 1) / BLOCK;
+    std::vector<size> counts(blocks);
+    {
+      TaskPool::Group group;
+      for (size b = 0; blocks > b; ++b) {
+        pool_.spawn(group, [&, b]() {
+          T * const begin = first + b * BLOCK, * const end = first + std::min(length, (b + 1) * BLOCK);
+          counts[b] = lomuto(begin, end, less) - begin;
+        });
+      }
+      pool_.wait(group);
+    }
+
+    /*
+     * misplaced intervals, in order: [begin, end) of each block past the
+     * split that still holds less elements, and before the split that
+     * holds the others.
+     */
+    size split = 0;
+    for (const size count : counts) {
+      split += count;
+    }
+    struct Interval { size begin, end, offset; };
+    std::vector<Interval> left, right;
+    size left_total = 0, right_total = 0;
+    for (size b = 0; blocks > b; ++b) {
+      const size begin = b * BLOCK, middle = begin + counts[b], end = std::min(length, (b + 1) * BLOCK);
+      if (split > middle && middle < end) {
+        left.push_back(Interval{middle, std::min(end, split), left_total});
+        left_total += left.back().end - left.back().begin;
+      }
+      if (split < middle) {
+        right.push_back(Interval{std::max(begin, split), middle, right_total});
+        right_total += right.back().end - right.back().begin;
+      }
+    }
+    assert(left_total == right_total);
+
+    const auto locate = [](const std::vector<Interval> & intervals, const size i) {
+      auto interval = std::upper_bound(intervals.begin(), intervals.end(), i,
+          [](const size i, const Interval & interval) { return i < interval.offset; });
+      return interval - 1;
+    };
+    TaskPool::Group group;
+    for (size begin = 0; left_total > begin; begin += BLOCK) {
+      pool_.spawn(group, [&, begin]() {
+        const size end = std::min(left_total, begin + BLOCK);
+        auto l = locate(left, begin), r = locate(right, begin);
+        size i = l->begin + (begin - l->offset), j = r->begin + (begin - r->offset);
+        for (size k = begin; end > k; ++k) {
+          if (l->end == i) {
+            ++l;
+            i = l->begin;
+          }
+          if (r->end == j) {
+            ++r;
+            j = r->begin;
+          }
+          std::swap(first[i++], first[j++]);
+        }
+      });
+    }
+    pool_.wait(group);
+    return first + split;
+  }
+
+  TaskPool & pool_;
+};
@@ -1,46 +1,154 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
-template<typename T>
-class Quicksort {
-public:
-  void operator()(T * t, std::size_t size) {
-    /* the first iteration picks pivot as the very first element. */
-    quicksort(t, 0, size - 1);
-  }
+#include <cassert>
+
+#include "parallel-quicksort.h"
+#include "quicksort.h"
+#include "selection.h"
+
+template<class SORT>
+double time(std::vector<int> array, SORT && sort) {
+  const auto start = std::chrono::steady_clock::now();
+  sort(array.data(), array.size());
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  assert(std::is_sorted(array.begin(), array.end()));
+  return seconds;
+}
 
-private:
-  void quicksort(T * a, int low, int high) {
-    if (low >= high) {
-      return;
+/* random, sorted, reversed, organ-pipe and few unique inputs */
+void benchmark(const std::size_t size) {
+  std::mt19937 generator(size);
+  std::vector<std::pair<const char *, std::vector<int>>> inputs;
+  for (const char * name : {"random", "sorted", "reversed", "organ-pipe", "few unique"}) {
+    inputs.emplace_back(name, std::vector<int>(size));
+  }
+  for (std::size_t i = 0; size > i; ++i) {
+    inputs[0].second[i] = generator();
+    inputs[1].second[i] = i;
+    inputs[2].second[i] = size - i;
+    inputs[3].second[i] = size / 2 > i ? i : size - i;
+    inputs[4].second[i] = generator() % 16;
+  }
+  for (const auto & [name, input] : inputs) {
+    std::cout << name << std::endl;
+    /* the textbook pivot goes quadratic, and as deep, on anything but random input */
+    if (&input == &inputs[0].second) {
+      std::cout << "  Quicksort: " << time(input, Quicksort<int>()) << "s" << std::endl;
     }
-    const int pivot = partition(a, low, high);
-    quicksort(a, low, pivot);
-    quicksort(a, pivot + 1, high);
+    std::cout << "  Introsort: " << time(input, Introsort<int>()) << "s" << std::endl;
+    std::cout << "  Pdqsort: " << time(input, Pdqsort<int>()) << "s" << std::endl;
+    std::cout << "  std::sort: " << time(input, [](int * array, const std::size_t size) {
+      std::sort(array, array + size);
+    }) << "s" << std::endl;
   }
+}
 
-  /* hoare's partition scheme */
-  int partition(T * a, int low, int high) {
-    const T pivot = a[low];
-    int i = low - 1;
-    int j = high + 1;
-    while (true) {
-      do {
-        i++;
-      } while(a[i] < pivot);
-      do {
-        j--;
-      } while(a[j] > pivot);
-      if (i >= j) {
-        return j;
-      }
-      std::swap(a[i], a[j]);
+/*
+ * sorts size random ints with 1, 2, 4 ... max_threads threads, the input
+ * is generated again in place for every run so only one array is live.
+ */
+void parallel_benchmark(const std::size_t size, const std::size_t max_threads) {
+  std::vector<int> array(size);
+  double serial = 0;
+  std::cout << "threads, seconds, speed-up" << std::endl;
+  for (std::size_t threads = 1; max_threads >= threads; threads *= 2) {
+    std::mt19937 generator(size);
+    for (auto & item : array) {
+      item = generator();
+    }
+    TaskPool pool(threads);
+    const auto start = std::chrono::steady_clock::now();
+    ParallelQuicksort<int>{pool}(array.data(), size);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(std::is_sorted(array.begin(), array.end()));
+    if (1 == threads) {
+      serial = seconds;
     }
+    std::cout << threads << ", " << seconds << ", " << serial / seconds << std::endl;
+  }
+}
+
+/*
+ * the median and the k greatest of size random ints, selected against
+ * sorting everything, checked against the standard library.
+ */
+void selection_benchmark(const std::size_t size, const std::size_t k, const std::size_t threads) {
+  std::mt19937 generator(size);
+  std::vector<int> input(size);
+  for (auto & item : input) {
+    item = generator();
   }
-};
+  std::vector<int> expected(input);
+  std::sort(expected.begin(), expected.end());
+
+  const auto run = [](const char * name, auto && f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    std::cout << "  " << name << ": "
+      << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+  };
+
+  std::cout << "median" << std::endl;
+  {
+    std::vector<int> array(input);
+    run("Pdqsort", [&]() { Pdqsort<int>()(array.data(), size); });
+  }
+  {
+    std::vector<int> array(input);
+    run("NthElement", [&]() { NthElement<int>()(array.data(), size, size / 2); });
+    assert(expected[size / 2] == array[size / 2]);
+  }
+  {
+    std::vector<int> array(input);
+    run("std::nth_element", [&]() { std::nth_element(array.begin(), array.begin() + size / 2, array.end()); });
+  }
+
+  std::cout << k << " smallest, sorted" << std::endl;
+  {
+    std::vector<int> array(input);
+    run("PartialSort", [&]() { PartialSort<int>()(array.data(), size, k); });
+    assert(std::equal(array.begin(), array.begin() + k, expected.begin()));
+  }
+  {
+    std::vector<int> array(input);
+    run("std::partial_sort", [&]() { std::partial_sort(array.begin(), array.begin() + k, array.end()); });
+  }
+
+  std::cout << k << " greatest, sorted" << std::endl;
+  const std::vector<int> greatest(expected.rbegin(), expected.rbegin() + k);
+  {
+    std::vector<int> result;
+    run("TopK", [&]() {
+      TopK<int> top(k);
+      top.push(input.data(), input.data() + size);
+      result = std::move(top).result();
+    });
+    assert(greatest == result);
+  }
+  {
+    TaskPool pool(threads);
+    std::vector<int> result;
+    run("ParallelTopK", [&]() { result = ParallelTopK<int>{pool}(input.data(), size, k); });
+    assert(greatest == result);
+  }
+}
 
 int main(int argc, char * * argv) {
-  if (1 < argc) {
+  if (2 < argc && std::string("benchmark") == argv[1]) {
+    benchmark(std::stoul(argv[2]));
+  } else if (1 < argc && std::string("parallel-benchmark") == argv[1]) {
+    parallel_benchmark(2 < argc ? std::stoul(argv[2]) : 1000000000,
+        3 < argc ? std::stoul(argv[3]) : std::thread::hardware_concurrency());
+  } else if (2 < argc && std::string("selection-benchmark") == argv[1]) {
+    selection_benchmark(std::stoul(argv[2]), 3 < argc ? std::stoul(argv[3]) : 1000,
+        4 < argc ? std::stoul(argv[4]) : std::thread::hardware_concurrency());
+  } else if (1 < argc) {
     // get size from command line argument.
     const size_t size = std::atoi(argv[1]);
 
@@ -48,7 +156,7 @@ int main(int argc, char * * argv) {
     auto array = new int[size];
     srand(time(nullptr));
     for (int i = 0; size > i; ++i) {
-      array[i] = rand() % 101;
+      array[i] = rand();
     }
     
     {
@@ -68,7 +176,10 @@ int main(int argc, char * * argv) {
     // delete the array.
     delete [] array;
   } else {
-    std::cerr << "usage: " << argv[0] << " (size of array)" << std::endl;
+    std::cerr << "usage: " << argv[0] << " (size of array)" << std::endl
+      << "       " << argv[0] << " benchmark (size of array)" << std::endl
+      << "       " << argv[0] << " parallel-benchmark [size of array] [threads]" << std::endl
+      << "       " << argv[0] << " selection-benchmark (size of array) [k] [threads]" << std::endl;
   }
   return 0;
 }
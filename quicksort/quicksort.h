@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+template<typename T>
+class Quicksort {
+public:
+  void operator()(T * t, std::size_t size) {
+    /* the first iteration picks pivot as the very first element. */
+    quicksort(t, 0, size - 1);
+  }
+
+private:
+  void quicksort(T * a, int low, int high) {
+    if (low >= high) {
+      return;
+    }
+    const int pivot = partition(a, low, high);
+    quicksort(a, low, pivot);
+    quicksort(a, pivot + 1, high);
+  }
+
+  /* hoare's partition scheme */
+  int partition(T * a, int low, int high) {
+    const T pivot = a[low];
+    int i = low - 1;
+    int j = high + 1;
+    while (true) {
+      do {
+        i++;
+      } while(a[i] < pivot);
+      do {
+        j--;
+      } while(a[j] > pivot);
+      if (i >= j) {
+        return j;
+      }
+      std::swap(a[i], a[j]);
+    }
+  }
+};
+
+/*
+ * Introsort
+ * ---------
+ * Quicksort for production: the pivot is the median of three, or
+ * Tukey's ninther (median of three medians of three) above NINTHER
+ * elements, so sorted and reversed input split evenly. it recurses into
+ * the smaller side and loops on the larger one, which bounds the stack
+ * to log2(n) frames, and falls back to heapsort past 2 * log2(n) levels
+ * so adversarial input stays O(n log n). partitions of up to INSERTION
+ * elements are left to insertion sort.
+ */
+template<typename T>
+class Introsort {
+public:
+  using size = std::size_t;
+  static constexpr size INSERTION = 16;
+  static constexpr size NINTHER = 128;
+
+  void operator()(T * a, const size length) {
+    if (2 > length) {
+      return;
+    }
+    introsort(a, a + length, 2 * static_cast<size>(std::log2(length)));
+  }
+
+  /* shared with the variants built on top */
+  static void insertion_sort(T * first, T * last) {
+    for (T * i = first + 1; last > i; ++i) {
+      T item{std::move(*i)};
+      T * j = i;
+      for (; first < j && item < *(j - 1); --j) {
+        *j = std::move(*(j - 1));
+      }
+      *j = std::move(item);
+    }
+  }
+
+  static void heapsort(T * first, T * last) {
+    const size length = last - first;
+    if (2 > length) {
+      return;
+    }
+    for (size i = length / 2; 0 < i--;) {
+      sift_down(first, i, length);
+    }
+    for (size i = length - 1; 0 < i; --i) {
+      std::swap(first[0], first[i]);
+      sift_down(first, 0, i);
+    }
+  }
+
+  static T * median_of_three(T * a, T * b, T * c) {
+    if (*b < *a) {
+      std::swap(a, b);
+    }
+    if (*c < *b) {
+      std::swap(b, c);
+      if (*b < *a) {
+        std::swap(a, b);
+      }
+    }
+    return b;
+  }
+
+  /* leaves the chosen pivot at first */
+  static void choose_pivot(T * first, T * last) {
+    const size length = last - first, half = length / 2;
+    T * pivot;
+    if (NINTHER < length) {
+      const size eighth = length / 8;
+      pivot = median_of_three(
+          median_of_three(first, first + eighth, first + 2 * eighth),
+          median_of_three(first + half - eighth, first + half, first + half + eighth),
+          median_of_three(last - 1 - 2 * eighth, last - 1 - eighth, last - 1));
+    } else {
+      pivot = median_of_three(first, first + half, last - 1);
+    }
+    std::swap(*first, *pivot);
+  }
+
+  /*
+   * hoare's partition scheme around *first, returns the end of the left
+   * side. the scan from the left would stop at first itself, so it starts
+   * there and never points before the array.
+   */
+  static T * partition(T * first, T * last) {
+    const T pivot = *first;
+    T * i = first;
+    T * j = last;
+    while (true) {
+      do {
+        --j;
+      } while (pivot < *j);
+      if (i >= j) {
+        return j + 1;
+      }
+      std::swap(*i, *j);
+      while (*++i < pivot) { }
+    }
+  }
+
+  /* max-heap on heap[0, length), the item at i moves down to its place */
+  static void sift_down(T * heap, size i, const size length) {
+    T item{std::move(heap[i])};
+    while (true) {
+      size child = 2 * i + 1;
+      if (length <= child) {
+        break;
+      }
+      if (length > child + 1 && heap[child] < heap[child + 1]) {
+        ++child;
+      }
+      if ( ! (item < heap[child])) {
+        break;
+      }
+      heap[i] = std::move(heap[child]);
+      i = child;
+    }
+    heap[i] = std::move(item);
+  }
+
+private:
+  static void introsort(T * first, T * last, size depth) {
+    while (INSERTION < static_cast<size>(last - first)) {
+      if (0 == depth--) {
+        heapsort(first, last);
+        return;
+      }
+      choose_pivot(first, last);
+      T * const middle = partition(first, last);
+      if (middle - first < last - middle) {
+        introsort(first, middle, depth);
+        first = middle;
+      } else {
+        introsort(middle, last, depth);
+        last = middle;
+      }
+    }
+    insertion_sort(first, last);
+  }
+};
+
+/*
+ * Pattern-Defeating Quicksort
+ * ---------------------------
+ * Introsort with the partition taken from BlockQuicksort: comparisons
+ * against the pivot only record offsets of misplaced elements into two
+ * small buffers, BLOCK elements at a time, and the swaps then run from
+ * the buffers with no branch depending on the data.
+ *
+ * on top of that, after Orson Peters' pdqsort:
+ * - a partition that needed no swap is finished by insertion sort,
+ *   giving up after PARTIAL_INSERTION moves, so sorted runs are O(n).
+ * - when the pivot equals the element left of the partition (which is
+ *   a previous pivot, hence not greater than anything here) the equal
+ *   keys are split off by partition_left and never looked at again,
+ *   so few unique keys are O(n k).
+ * - unbalanced partitions swap some elements around to break patterns
+ *   and after log2(n) of them it falls back to heapsort.
+ */
+template<typename T>
+class Pdqsort {
+public:
+  using size = std::size_t;
+  static constexpr size INSERTION = 24;
+  static constexpr size NINTHER = 128;
+  static constexpr size PARTIAL_INSERTION = 8;
+  static constexpr size BLOCK = 64;
+
+  void operator()(T * a, const size length) {
+    if (2 > length) {
+      return;
+    }
+    pdqsort(a, a + length, static_cast<size>(std::log2(length)), true);
+  }
+
+  /* the elements equal to *first (the pivot) go left, returns the pivot position */
+  static T * partition_left(T * const begin, T * const end) {
+    T pivot{std::move(*begin)};
+    T * first = begin, * last = end;
+    while (pivot < *--last) { }
+    if (end == last + 1) {
+      while (first < last && ! (pivot < *++first)) { }
+    } else {
+      while ( ! (pivot < *++first)) { }
+    }
+    while (first < last) {
+      std::swap(*first, *last);
+      while (pivot < *--last) { }
+      while ( ! (pivot < *++first)) { }
+    }
+    *begin = std::move(*last);
+    *last = std::move(pivot);
+    return last;
+  }
+
+  /*
+   * the elements equal to *first (the pivot) go right, returns the pivot
+   * position and whether the range was partitioned already.
+   */
+  static std::pair<T *, bool> partition_right(T * const begin, T * const end) {
+    T pivot{std::move(*begin)};
+    T * first = begin, * last = end;
+    /* the median of three guards both scans */
+    while (*++first < pivot) { }
+    if (begin == first - 1) {
+      while (first < last && ! (*--last < pivot)) { }
+    } else {
+      while ( ! (*--last < pivot)) { }
+    }
+    const bool partitioned = first >= last;
+
+    if ( ! partitioned) {
+      std::swap(*first, *last);
+      ++first;
+
+      unsigned char left[BLOCK], right[BLOCK];
+      size left_count = 0, right_count = 0, left_start = 0, right_start = 0;
+
+      while (static_cast<size>(last - first) > 2 * BLOCK) {
+        if (0 == left_count) {
+          left_start = 0;
+          T * item = first;
+          for (size i = 0; BLOCK > i; ++item) {
+            left[left_count] = i++;
+            left_count += ! (*item < pivot);
+          }
+        }
+        if (0 == right_count) {
+          right_start = 0;
+          T * item = last;
+          for (size i = 0; BLOCK > i;) {
+            right[right_count] = ++i;
+            right_count += *--item < pivot;
+          }
+        }
+        const size count = std::min(left_count, right_count);
+        swap_offsets(first, last, left + left_start, right + right_start, count, left_count == right_count);
+        left_count -= count;
+        right_count -= count;
+        left_start += count;
+        right_start += count;
+        if (0 == left_count) {
+          first += BLOCK;
+        }
+        if (0 == right_count) {
+          last -= BLOCK;
+        }
+      }
+
+      /* less than two blocks left, at most one of the buffers still has offsets */
+      size left_size = 0, right_size = 0;
+      const size unknown = (last - first) - (0 < right_count || 0 < left_count ? BLOCK : 0);
+      if (0 < right_count) {
+        left_size = unknown;
+        right_size = BLOCK;
+      } else if (0 < left_count) {
+        left_size = BLOCK;
+        right_size = unknown;
+      } else {
+        left_size = unknown / 2;
+        right_size = unknown - left_size;
+      }
+      if (0 < unknown && 0 == left_count) {
+        left_start = 0;
+        T * item = first;
+        for (size i = 0; left_size > i; ++item) {
+          left[left_count] = i++;
+          left_count += ! (*item < pivot);
+        }
+      }
+      if (0 < unknown && 0 == right_count) {
+        right_start = 0;
+        T * item = last;
+        for (size i = 0; right_size > i;) {
+          right[right_count] = ++i;
+          right_count += *--item < pivot;
+        }
+      }
+      const size count = std::min(left_count, right_count);
+      swap_offsets(first, last, left + left_start, right + right_start, count, left_count == right_count);
+      left_count -= count;
+      right_count -= count;
+      left_start += count;
+      right_start += count;
+      if (0 == left_count) {
+        first += left_size;
+      }
+      if (0 == right_count) {
+        last -= right_size;
+      }
+
+      /* whatever is left in a buffer belongs to the far end of the other side */
+      if (0 < left_count) {
+        while (0 < left_count--) {
+          std::swap(first[left[left_start + left_count]], *--last);
+        }
+        first = last;
+      }
+      if (0 < right_count) {
+        while (0 < right_count--) {
+          std::swap(*(last - right[right_start + right_count]), *first);
+          ++first;
+        }
+        last = first;
+      }
+    }
+
+    T * const pivot_position = first - 1;
+    *begin = std::move(*pivot_position);
+    *pivot_position = std::move(pivot);
+    return {pivot_position, partitioned};
+  }
+
+private:
+  static void sort2(T * a, T * b) {
+    if (*b < *a) {
+      std::swap(*a, *b);
+    }
+  }
+
+  static void sort3(T * a, T * b, T * c) {
+    sort2(a, b);
+    sort2(b, c);
+    sort2(a, b);
+  }
+
+  /*
+   * exchanges first[left[i]] with last[-right[i]]. with unequal counts a
+   * cyclic permutation moves every element once instead of swapping.
+   */
+  static void swap_offsets(T * first, T * last, const unsigned char * left, const unsigned char * right, const size count, const bool swaps) {
+    if (swaps) {
+      for (size i = 0; count > i; ++i) {
+        std::swap(first[left[i]], *(last - right[i]));
+      }
+    } else if (0 < count) {
+      T * l = first + left[0];
+      T * r = last - right[0];
+      T item{std::move(*l)};
+      *l = std::move(*r);
+      for (size i = 1; count > i; ++i) {
+        l = first + left[i];
+        *r = std::move(*l);
+        r = last - right[i];
+        *l = std::move(*r);
+      }
+      *r = std::move(item);
+    }
+  }
+
+  /* insertion sort that gives up after PARTIAL_INSERTION moves */
+  static bool partial_insertion_sort(T * const begin, T * const end) {
+    if (begin == end) {
+      return true;
+    }
+    size moves = 0;
+    for (T * i = begin + 1; end != i; ++i) {
+      if (*i < *(i - 1)) {
+        T item{std::move(*i)};
+        T * j = i;
+        do {
+          *j = std::move(*(j - 1));
+          --j;
+        } while (begin != j && item < *(j - 1));
+        *j = std::move(item);
+        moves += i - j;
+        if (PARTIAL_INSERTION < moves) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static void pdqsort(T * begin, T * end, size bad, bool leftmost) {
+    while (true) {
+      const size length = end - begin;
+      if (INSERTION > length) {
+        Introsort<T>::insertion_sort(begin, end);
+        return;
+      }
+
+      const size half = length / 2;
+      if (NINTHER < length) {
+        sort3(begin, begin + half, end - 1);
+        sort3(begin + 1, begin + (half - 1), end - 2);
+        sort3(begin + 2, begin + (half + 1), end - 3);
+        sort3(begin + (half - 1), begin + half, begin + (half + 1));
+        std::swap(*begin, *(begin + half));
+      } else {
+        sort3(begin + half, begin, end - 1);
+      }
+
+      /* begin[-1] was a pivot, equal keys here need no more sorting */
+      if ( ! leftmost && ! (*(begin - 1) < *begin)) {
+        begin = partition_left(begin, end) + 1;
+        continue;
+      }
+
+      const auto [pivot, partitioned] = partition_right(begin, end);
+      const size left = pivot - begin, right = end - (pivot + 1);
+      if (length / 8 > left || length / 8 > right) {
+        if (0 == --bad) {
+          Introsort<T>::heapsort(begin, end);
+          return;
+        }
+        if (INSERTION <= left) {
+          std::swap(*begin, *(begin + left / 4));
+          std::swap(*(pivot - 1), *(pivot - left / 4));
+          if (NINTHER < left) {
+            std::swap(*(begin + 1), *(begin + (left / 4 + 1)));
+            std::swap(*(begin + 2), *(begin + (left / 4 + 2)));
+            std::swap(*(pivot - 2), *(pivot - (left / 4 + 1)));
+            std::swap(*(pivot - 3), *(pivot - (left / 4 + 2)));
+          }
+        }
+        if (INSERTION <= right) {
+          std::swap(*(pivot + 1), *(pivot + (1 + right / 4)));
+          std::swap(*(end - 1), *(end - right / 4));
+          if (NINTHER < right) {
+            std::swap(*(pivot + 2), *(pivot + (2 + right / 4)));
+            std::swap(*(pivot + 3), *(pivot + (3 + right / 4)));
+            std::swap(*(end - 2), *(end - (1 + right / 4)));
+            std::swap(*(end - 3), *(end - (2 + right / 4)));
+          }
+        }
+      } else if (partitioned && partial_insertion_sort(begin, pivot) && partial_insertion_sort(pivot + 1, end)) {
+        return;
+      }
+
+      pdqsort(begin, pivot, bad, leftmost);
+      begin = pivot + 1;
+      leftmost = false;
+    }
+  }
+};
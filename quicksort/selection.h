@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "../mergesort/task-pool.h"
+#include "../priority-heaps/priority-heap.h"
+#include "quicksort.h"
+
+/*
+ * Introselect
+ * -----------
+ * nth_element on the Introsort partition: after every partition only
+ * the side holding position n is kept, so on average it touches 2n
+ * elements instead of sorting n log n. the pivot is the same median of
+ * three or ninther, and past 2 * log2(n) partitions it gives up and
+ * heapsorts what is left, which bounds the worst case to O(n log n).
+ *
+ * afterwards a[n] is the element a full sort would put there, nothing
+ * before it is greater and nothing after it is less.
+ */
+template<typename T>
+class NthElement {
+public:
+  using size = std::size_t;
+
+  void operator()(T * a, const size length, const size n) {
+    if (length <= n) {
+      return;
+    }
+    T * first = a, * last = a + length, * const nth = a + n;
+    size depth = 2 * static_cast<size>(std::log2(length));
+    while (Introsort<T>::INSERTION < static_cast<size>(last - first)) {
+      if (0 == depth--) {
+        Introsort<T>::heapsort(first, last);
+        return;
+      }
+      Introsort<T>::choose_pivot(first, last);
+      T * const middle = Introsort<T>::partition(first, last);
+      if (nth < middle) {
+        last = middle;
+      } else {
+        first = middle;
+      }
+    }
+    Introsort<T>::insertion_sort(first, last);
+  }
+};
+
+/*
+ * sorts the k smallest elements into a[0, k), the rest is left in no
+ * particular order. for k well below length a max-heap of the first k
+ * elements is fed the rest, one comparison against its top each, like
+ * std::partial_sort. for larger k a selection around k - 1 followed by
+ * Pdqsort on the front is O(n + k log k) instead of O(n log k).
+ */
+template<typename T>
+class PartialSort {
+public:
+  using size = std::size_t;
+  static constexpr size HEAP = 64;
+
+  void operator()(T * a, const size length, size k) {
+    k = std::min(k, length);
+    if (0 == k) {
+      return;
+    }
+    if (length / HEAP > k) {
+      for (size i = k / 2; 0 < i--;) {
+        Introsort<T>::sift_down(a, i, k);
+      }
+      for (size i = k; length > i; ++i) {
+        if (a[i] < a[0]) {
+          std::swap(a[0], a[i]);
+          Introsort<T>::sift_down(a, 0, k);
+        }
+      }
+      Pdqsort<T>()(a, k);
+    } else {
+      /* a[k - 1] is in place already */
+      NthElement<T>()(a, length, k - 1);
+      Pdqsort<T>()(a, k - 1);
+    }
+  }
+};
+
+/*
+ * Streaming Top-K
+ * ---------------
+ * the k greatest elements of a stream of unknown length, in O(k) memory:
+ * a min-heap of the best k so far, whose top is the one to beat. once
+ * the heap is full an element costs one comparison, and log k only when
+ * it gets in, so n elements are O(n log k) at worst and close to O(n)
+ * for random input.
+ */
+template<typename T>
+class TopK {
+public:
+  using size = std::size_t;
+
+  explicit TopK(const size k) : k_(k) { }
+
+  void push(const T & item) {
+    if (k_ > heap_.length()) {
+      heap_.push(item);
+    } else if (0 < k_ && heap_.top() < item) {
+      heap_.replace(item);
+    }
+  }
+
+  void push(const T * first, const T * const last) {
+    for (; last != first; ++first) {
+      push(*first);
+    }
+  }
+
+  size length() const { return heap_.length(); }
+
+  /* the greatest first */
+  std::vector<T> result() && {
+    std::vector<T> result(std::move(heap_.container_));
+    heap_.container_.clear();
+    Pdqsort<T>()(result.data(), result.size());
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+
+private:
+  size k_;
+  PriorityHeap<T, 4> heap_;
+};
+
+/*
+ * top-k of an array on a TaskPool: every BLOCK elements stream into
+ * their own TopK, the candidates of all blocks, at most k each, are
+ * gathered and the k greatest of them selected with NthElement. blocks
+ * are fixed by the length alone, so the result does not depend on the
+ * number of threads.
+ */
+template<typename T>
+class ParallelTopK {
+public:
+  using size = std::size_t;
+  static constexpr size BLOCK = 1 << 20;
+
+  explicit ParallelTopK(TaskPool & pool) : pool_(pool) { }
+
+  /* the greatest first */
+  std::vector<T> operator()(const T * a, const size length, size k) {
+    k = std::min(k, length);
+    const size blocks = std::max<size>(1, (length + BLOCK - 1) / BLOCK);
+    std::vector<std::vector<T>> candidates(blocks);
+    TaskPool::Group group;
+    for (size b = 0; blocks > b; ++b) {
+      pool_.spawn(group, [&, b]() {
+        TopK<T> top(k);
+        top.push(a + b * BLOCK, a + std::min(length, (b + 1) * BLOCK));
+        candidates[b] = std::move(top).result();
+      });
+    }
+    pool_.wait(group);
+
+    std::vector<T> result;
+    result.reserve(blocks * k);
+    for (const auto & block : candidates) {
+      result.insert(result.end(), block.begin(), block.end());
+    }
+    const size skip = result.size() - k;
+    NthElement<T>()(result.data(), result.size(), skip);
+    result.erase(result.begin(), result.begin() + skip);
+    Pdqsort<T>()(result.data(), result.size());
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+
+private:
+  TaskPool & pool_;
+};
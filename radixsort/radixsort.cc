@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cassert>
+
+#include "sorters.h"
+
+/* runs every sorter on a copy of input and checks it against std::sort */
+template<typename T>
+void benchmark(const char * type, const std::vector<T> & input) {
+  std::vector<T> expected(input);
+  std::sort(expected.begin(), expected.end());
+  std::cout << type << ", " << input.size() << " keys" << std::endl;
+  for (auto & [name, sorter] : sorters<T>()) {
+    std::vector<T> array(input);
+    const auto start = std::chrono::steady_clock::now();
+    sorter(array.data(), array.size());
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert(expected == array);
+    std::cout << "  " << name << ": " << seconds << "s" << std::endl;
+  }
+}
+
+int main(int argc, char * * argv) {
+  const std::size_t size = 1 < argc ? std::stoul(argv[1]) : 10000000;
+  std::mt19937_64 generator(size);
+
+  {
+    std::vector<std::int32_t> input(size);
+    for (auto & item : input) { item = generator(); }
+    benchmark("int32", input);
+  }
+  {
+    std::vector<std::uint64_t> input(size);
+    for (auto & item : input) { item = generator(); }
+    benchmark("uint64", input);
+  }
+  {
+    /* only 24 significant bits, the top byte pass is skipped */
+    std::vector<std::uint32_t> input(size);
+    for (auto & item : input) { item = generator() & 0xffffff; }
+    benchmark("uint32 < 2^24", input);
+  }
+  {
+    std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+    std::vector<double> input(size);
+    for (auto & item : input) { item = distribution(generator); }
+    benchmark("double", input);
+  }
+  {
+    /* hex ids with a shared prefix, like keys in a store */
+    std::vector<std::string> input(size / 4);
+    for (auto & item : input) {
+      item = "user:";
+      for (std::size_t length = 4 + generator() % 12; 0 < length; --length) {
+        item += "0123456789abcdef"[generator() % 16];
+      }
+    }
+    benchmark("string", input);
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+ * maps keys to unsigned integers with the same order: signed integers
+ * flip the sign bit, negative floats flip every bit and positive ones
+ * only the sign bit.
+ */
+template<typename T, typename = void>
+struct RadixKey;
+
+template<typename T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  static Unsigned get(const T item) {
+    Unsigned key = static_cast<Unsigned>(item);
+    if (std::is_signed<T>::value) {
+      key ^= Unsigned(1) << (std::numeric_limits<Unsigned>::digits - 1);
+    }
+    return key;
+  }
+};
+
+template<typename T>
+struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using Unsigned = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+  static Unsigned get(const T item) {
+    Unsigned key;
+    std::memcpy(&key, &item, sizeof(key));
+    const Unsigned sign = Unsigned(1) << (std::numeric_limits<Unsigned>::digits - 1);
+    return 0 != (key & sign) ? ~key : key | sign;
+  }
+};
+
+/*
+ * LSD Radix Sort
+ * --------------
+ * stable, one byte per pass, least significant first. a single read
+ * builds the histograms of every byte, passes whose byte is the same
+ * for all keys are skipped. scattering goes through a cache line sized
+ * buffer per bucket (software write-combining): the 256 write streams
+ * hit the buffers in L1 and memory only sees whole lines. passes ping-
+ * pong between array and one scratch array.
+ */
+template<typename T>
+class RadixSort {
+  static_assert(std::is_arithmetic<T>::value, "std::string has its own specialization");
+  using Key = RadixKey<T>;
+  using Unsigned = typename Key::Unsigned;
+
+public:
+  using size = std::size_t;
+  static constexpr size BYTES = sizeof(T);
+  static constexpr size LINE = std::max<size>(1, 64 / sizeof(T));
+  /* below this std::sort wins, it also keeps histograms off tiny inputs */
+  static constexpr size SMALL = 256;
+
+  void operator()(T * a, const size length) {
+    if (SMALL > length) {
+      std::sort(a, a + length);
+      return;
+    }
+
+    std::array<std::array<size, 256>, BYTES> histograms{};
+    for (size i = 0; length > i; ++i) {
+      const Unsigned key = Key::get(a[i]);
+      for (size b = 0; BYTES > b; ++b) {
+        ++histograms[b][(key >> (8 * b)) & 0xff];
+      }
+    }
+
+    std::unique_ptr<T[]> scratch;
+    T * source = a, * destination = nullptr;
+    for (size b = 0; BYTES > b; ++b) {
+      const auto & histogram = histograms[b];
+      if (length == histogram[(Key::get(a[0]) >> (8 * b)) & 0xff]) {
+        continue;
+      }
+      if ( ! scratch) {
+        scratch.reset(new T[length]);
+        destination = scratch.get();
+      }
+      scatter(source, destination, length, histogram, 8 * b);
+      std::swap(source, destination);
+    }
+    if (a != source) {
+      std::copy(source, source + length, a);
+    }
+  }
+
+private:
+  static void scatter(const T * source, T * destination, const size length, const std::array<size, 256> & histogram, const size shift) {
+    std::array<size, 256> offsets;
+    for (size i = 0, offset = 0; 256 > i; ++i) {
+      offsets[i] = offset;
+      offset += histogram[i];
+    }
+    alignas(64) T buffers[256][LINE];
+    std::array<std::uint8_t, 256> fill{};
+    for (size i = 0; length > i; ++i) {
+      const size bucket = (Key::get(source[i]) >> shift) & 0xff;
+      buffers[bucket][fill[bucket]++] = source[i];
+      if (LINE == fill[bucket]) {
+        std::memcpy(destination + offsets[bucket], buffers[bucket], sizeof(buffers[bucket]));
+        offsets[bucket] += LINE;
+        fill[bucket] = 0;
+      }
+    }
+    for (size bucket = 0; 256 > bucket; ++bucket) {
+      std::memcpy(destination + offsets[bucket], buffers[bucket], sizeof(T) * fill[bucket]);
+    }
+  }
+};
+
+/*
+ * MSD Radix Sort for strings
+ * --------------------------
+ * American flag sort: counts the byte at depth d, then permutes the
+ * strings into their buckets in place by following cycles, and recurses
+ * into each bucket at depth d + 1. strings ending at d form bucket 0
+ * and are done. buckets under SMALL elements are insertion sorted on
+ * the remaining suffixes. swapping std::string only swaps pointers.
+ */
+template<>
+class RadixSort<std::string> {
+public:
+  using size = std::size_t;
+  static constexpr size SMALL = 32;
+
+  void operator()(std::string * a, const size length) {
+    sort(a, a + length, 0);
+  }
+
+private:
+  static size bucket(const std::string & s, const size depth) {
+    return s.size() > depth ? 1 + static_cast<unsigned char>(s[depth]) : 0;
+  }
+
+  static void insertion_sort(std::string * first, std::string * last, const size depth) {
+    const auto less = [depth](const std::string & a, const std::string & b) {
+      return 0 > a.compare(depth, std::string::npos, b, depth, std::string::npos);
+    };
+    for (std::string * i = first + 1; last > i; ++i) {
+      for (std::string * j = i; first < j && less(*j, *(j - 1)); --j) {
+        std::swap(*j, *(j - 1));
+      }
+    }
+  }
+
+  static void sort(std::string * first, std::string * last, const size depth) {
+    const size length = last - first;
+    if (SMALL > length) {
+      insertion_sort(first, last, depth);
+      return;
+    }
+
+    std::array<size, 257> counts{};
+    for (std::string * i = first; last != i; ++i) {
+      ++counts[bucket(*i, depth)];
+    }
+    std::array<size, 257> heads, tails;
+    for (size b = 0, offset = 0; 257 > b; ++b) {
+      heads[b] = offset;
+      offset += counts[b];
+      tails[b] = offset;
+    }
+
+    /* every slot from heads[b] on is unsorted, the string there travels until it lands in its own bucket */
+    for (size b = 0; 257 > b; ++b) {
+      while (heads[b] < tails[b]) {
+        std::string & item = first[heads[b]];
+        size target = bucket(item, depth);
+        while (b != target) {
+          std::swap(item, first[heads[target]++]);
+          target = bucket(item, depth);
+        }
+        ++heads[b];
+      }
+    }
+
+    for (size b = 1, offset = counts[0]; 257 > b; offset += counts[b], ++b) {
+      if (1 < counts[b]) {
+        sort(first + offset, first + offset + counts[b], depth + 1);
+      }
+    }
+  }
+};
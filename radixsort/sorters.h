@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../mergesort/mergesort.h"
+#include "../quicksort/quicksort.h"
+#include "radixsort.h"
+
+/*
+ * every sorter in the sandbox behind one interface: a functor taking
+ * (T *, std::size_t), so a benchmark can loop over them.
+ */
+template<typename T>
+using Sorter = std::function<void(T *, std::size_t)>;
+
+template<typename T>
+std::vector<std::pair<std::string, Sorter<T>>> sorters() {
+  return {
+    {"std::sort", [](T * a, const std::size_t size) { std::sort(a, a + size); }},
+    {"Quicksort", Quicksort<T>()},
+    {"Introsort", Introsort<T>()},
+    {"Pdqsort", Pdqsort<T>()},
+    {"Mergesort", Mergesort<T>()},
+    {"BottomUpMergesort", BottomUpMergesort<T>()},
+    {"AdaptiveMergesort", AdaptiveMergesort<T>()},
+    {"RadixSort", RadixSort<T>()},
+  };
+}
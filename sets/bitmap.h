@@ -0,0 +1,575 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "sets.h"
+
+/*
+ * Compressed Bitmap
+ * -----------------
+ * set of 64 bits ids after Roaring: the high 48 bits of an id pick a
+ * container, which holds the low 16 bits in whichever form is smaller:
+ * - ARRAY: up to ARRAY_MAX sorted values, 2 bytes each.
+ * - BITMAP: 2^16 bits, 8 KB, past ARRAY_MAX values.
+ * - RUN: sorted (start, length - 1) pairs, 4 bytes per run of
+ *   consecutive values, only made by optimize().
+ *
+ * AND, OR, XOR and ANDNOT work container by container: two arrays merge,
+ * an array against anything else is filtered by lookups when the result
+ * can only shrink, and the rest runs 64 bits at a time over bitmaps.
+ * results over ARRAY_MAX are bitmaps, the others arrays. cardinalities
+ * are kept per container, from popcount on bitmaps.
+ *
+ * serialize() writes a header, a fixed size descriptor per container and
+ * the containers 8 bytes aligned, so a View can answer contains() and
+ * cardinality() straight from a mapped file without parsing it. the
+ * format is native endian.
+ */
+class Bitmap {
+public:
+  using Id = std::uint64_t;
+  using Size = std::size_t;
+  static constexpr Size ARRAY_MAX = 4096;
+  static constexpr Size WORDS = (1 << 16) / 64;
+
+private:
+  struct Container {
+    enum Type : std::uint32_t { ARRAY, BITMAP, RUN };
+    Type type = ARRAY;
+    std::uint32_t cardinality = 0;
+    /* ARRAY: the values, RUN: start and length - 1 of every run */
+    std::vector<std::uint16_t> values;
+    /* BITMAP: WORDS words */
+    std::vector<std::uint64_t> words;
+  };
+
+  struct Header {
+    char magic[8];
+    std::uint64_t count;
+    std::uint64_t cardinality;
+  };
+
+  /* offset from the start of the buffer, size in values or in words */
+  struct Descriptor {
+    std::uint64_t key;
+    std::uint64_t offset;
+    std::uint32_t type;
+    std::uint32_t cardinality;
+    std::uint32_t size;
+    std::uint32_t padding;
+  };
+
+public:
+  Bitmap() = default;
+
+  /* from ids in any order, sorted ones append at the end of the last container */
+  explicit Bitmap(const std::vector<Id> & ids) {
+    for (const Id id : ids) {
+      push(id);
+    }
+  }
+
+  explicit Bitmap(const Set<Id> & set) {
+    for (const Id id : set.elements()) {
+      push(id);
+    }
+  }
+
+  Bitmap & push(const Id id) {
+    const Id key = id >> 16;
+    if (keys_.empty() || keys_.back() < key) {
+      keys_.push_back(key);
+      containers_.emplace_back();
+      insert(containers_.back(), id & 0xFFFF);
+      return *this;
+    }
+    const auto i = std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+    if (keys_[i] != key) {
+      keys_.insert(keys_.begin() + i, key);
+      containers_.emplace(containers_.begin() + i);
+    }
+    insert(containers_[i], id & 0xFFFF);
+    return *this;
+  }
+
+  bool contains(const Id id) const {
+    const auto key = std::lower_bound(keys_.begin(), keys_.end(), id >> 16);
+    return keys_.end() != key && *key == id >> 16 && contains(containers_[key - keys_.begin()], id & 0xFFFF);
+  }
+
+  Size cardinality() const {
+    Size cardinality = 0;
+    for (const auto & container : containers_) {
+      cardinality += container.cardinality;
+    }
+    return cardinality;
+  }
+
+  /* the ids, sorted */
+  std::vector<Id> vector() const {
+    std::vector<Id> ids;
+    ids.reserve(cardinality());
+    for (Size i = 0; keys_.size() > i; ++i) {
+      each(containers_[i], [&ids, high = keys_[i] << 16](const std::uint32_t low) { ids.push_back(high | low); });
+    }
+    return ids;
+  }
+
+  Set<Id> set() const { return Set<Id>(vector()); }
+
+  Bitmap operator & (const Bitmap & other) const { return combine(*this, other, AND); }
+  Bitmap operator | (const Bitmap & other) const { return combine(*this, other, OR); }
+  Bitmap operator ^ (const Bitmap & other) const { return combine(*this, other, XOR); }
+  Bitmap andnot(const Bitmap & other) const { return combine(*this, other, ANDNOT); }
+
+  bool operator == (const Bitmap & other) const { return vector() == other.vector(); }
+
+  /* turns every container into the smallest of the three forms */
+  Bitmap & optimize() {
+    for (auto & container : containers_) {
+      const Size runs = count_runs(container), run_bytes = 4 * runs;
+      const Size array_bytes = ARRAY_MAX >= container.cardinality ? 2 * container.cardinality : SIZE_MAX;
+      if (run_bytes < std::min<Size>(array_bytes, 8 * WORDS)) {
+        to_runs(container, runs);
+      } else if (array_bytes <= 8 * WORDS) {
+        to_array(container);
+      } else {
+        to_bitmap(container);
+      }
+    }
+    return *this;
+  }
+
+  /* bytes used by the containers */
+  Size bytes() const {
+    Size bytes = keys_.size() * (sizeof(Id) + sizeof(Container));
+    for (const auto & container : containers_) {
+      bytes += container.values.size() * 2 + container.words.size() * 8;
+    }
+    return bytes;
+  }
+
+  std::vector<char> serialize() const {
+    std::vector<Descriptor> descriptors(keys_.size());
+    Size offset = sizeof(Header) + descriptors.size() * sizeof(Descriptor);
+    for (Size i = 0; keys_.size() > i; ++i) {
+      const Container & container = containers_[i];
+      const Size size = Container::BITMAP == container.type ? container.words.size() : container.values.size();
+      descriptors[i] = Descriptor{keys_[i], offset, container.type, container.cardinality, static_cast<std::uint32_t>(size), 0};
+      offset += align(Container::BITMAP == container.type ? 8 * size : 2 * size);
+    }
+    std::vector<char> buffer(offset);
+    const Header header{{'R', 'O', 'A', 'R', 'I', 'N', 'G', '1'}, keys_.size(), cardinality()};
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    for (Size i = 0; keys_.size() > i; ++i) {
+      std::memcpy(buffer.data() + sizeof(header) + i * sizeof(Descriptor), &descriptors[i], sizeof(Descriptor));
+      const Container & container = containers_[i];
+      if (Container::BITMAP == container.type) {
+        std::memcpy(buffer.data() + descriptors[i].offset, container.words.data(), 8 * container.words.size());
+      } else {
+        std::memcpy(buffer.data() + descriptors[i].offset, container.values.data(), 2 * container.values.size());
+      }
+    }
+    return buffer;
+  }
+
+  /*
+   * a serialized bitmap read in place, from a mapped file for instance.
+   * the buffer is checked once here and must outlive the view: keys
+   * strictly increasing, every payload inside the buffer, BITMAP payloads
+   * of exactly WORDS words, ARRAY payloads of at most ARRAY_MAX values as
+   * many as their cardinality, RUN payloads of whole runs within 2^16
+   * values adding up to their cardinality.
+   */
+  class View {
+  public:
+    View(const char * data, const Size size) : data_(data) {
+      if (sizeof(Header) > size) {
+        throw std::runtime_error("bitmap is truncated");
+      }
+      std::memcpy(&header_, data, sizeof(header_));
+      if (0 != std::memcmp(header_.magic, "ROARING1", 8) || (size - sizeof(Header)) / sizeof(Descriptor) < header_.count) {
+        throw std::runtime_error("not a bitmap");
+      }
+      for (Size i = 0; header_.count > i; ++i) {
+        const Descriptor d = descriptor(i);
+        const Size bytes = (Container::BITMAP == d.type ? 8 : 2) * Size{d.size};
+        if (Container::RUN < d.type || size < d.offset || size - d.offset < bytes || 0 != d.offset % 8) {
+          throw std::runtime_error("bitmap container out of bounds");
+        }
+        if (0 < i && descriptor(i - 1).key >= d.key) {
+          throw std::runtime_error("bitmap keys out of order");
+        }
+        if ((1 << 16) < d.cardinality
+            || (Container::BITMAP == d.type && WORDS != d.size)
+            || (Container::ARRAY == d.type && (ARRAY_MAX < d.size || d.cardinality != d.size))
+            || (Container::RUN == d.type && (0 != d.size % 2 || d.cardinality != run_cardinality(d)))) {
+          throw std::runtime_error("bitmap container malformed");
+        }
+      }
+    }
+
+    Size cardinality() const { return header_.cardinality; }
+
+    bool contains(const Id id) const {
+      Size low = 0, high = header_.count;
+      while (low < high) {
+        const Size middle = low + (high - low) / 2;
+        if (descriptor(middle).key < id >> 16) {
+          low = middle + 1;
+        } else {
+          high = middle;
+        }
+      }
+      if (header_.count == low) {
+        return false;
+      }
+      const Descriptor d = descriptor(low);
+      if (d.key != id >> 16) {
+        return false;
+      }
+      const std::uint16_t value = id & 0xFFFF;
+      if (Container::BITMAP == d.type) {
+        std::uint64_t word;
+        std::memcpy(&word, data_ + d.offset + 8 * (value / 64), 8);
+        return 0 != (word >> (value % 64) & 1);
+      }
+      /* the last value not greater than the one sought, or the last run start */
+      const Size stride = Container::RUN == d.type ? 2 : 1;
+      Size first = 0, count = d.size / stride;
+      while (0 < count) {
+        const Size half = count / 2;
+        if (load(d, (first + half) * stride) <= value) {
+          first += half + 1;
+          count -= half + 1;
+        } else {
+          count = half;
+        }
+      }
+      if (0 == first) {
+        return false;
+      }
+      const std::uint16_t start = load(d, (first - 1) * stride);
+      return Container::RUN == d.type ? value - start <= load(d, (first - 1) * stride + 1) : value == start;
+    }
+
+    /* copies the containers out */
+    Bitmap bitmap() const {
+      Bitmap bitmap;
+      for (Size i = 0; header_.count > i; ++i) {
+        const Descriptor d = descriptor(i);
+        Container container;
+        container.type = static_cast<Container::Type>(d.type);
+        container.cardinality = d.cardinality;
+        if (Container::BITMAP == d.type) {
+          container.words.resize(d.size);
+          std::memcpy(container.words.data(), data_ + d.offset, 8 * Size{d.size});
+        } else {
+          container.values.resize(d.size);
+          std::memcpy(container.values.data(), data_ + d.offset, 2 * Size{d.size});
+        }
+        bitmap.keys_.push_back(d.key);
+        bitmap.containers_.push_back(std::move(container));
+      }
+      return bitmap;
+    }
+
+  private:
+    Descriptor descriptor(const Size i) const {
+      Descriptor d;
+      std::memcpy(&d, data_ + sizeof(Header) + i * sizeof(Descriptor), sizeof(d));
+      return d;
+    }
+
+    /* the values in the runs of d, 0 unless they stay within 2^16 */
+    Size run_cardinality(const Descriptor & d) const {
+      Size cardinality = 0;
+      for (Size r = 0; d.size > r; r += 2) {
+        const Size start = load(d, r), length = load(d, r + 1);
+        if (0xFFFF < start + length) {
+          return 0;
+        }
+        cardinality += length + 1;
+      }
+      return cardinality;
+    }
+
+    std::uint16_t load(const Descriptor & d, const Size i) const {
+      std::uint16_t value;
+      std::memcpy(&value, data_ + d.offset + 2 * i, 2);
+      return value;
+    }
+
+    const char * data_;
+    Header header_;
+  };
+
+  static Bitmap deserialize(const char * data, const Size size) { return View(data, size).bitmap(); }
+
+private:
+  enum Operation { AND, OR, XOR, ANDNOT };
+
+  static Size align(const Size bytes) { return (bytes + 7) & ~Size{7}; }
+
+  template<class F>
+  static void each(const Container & container, const F & f) {
+    switch (container.type) {
+    case Container::ARRAY:
+      for (const std::uint16_t value : container.values) {
+        f(value);
+      }
+      break;
+    case Container::BITMAP:
+      for (Size w = 0; WORDS > w; ++w) {
+        for (std::uint64_t word = container.words[w]; 0 != word; word &= word - 1) {
+          f(static_cast<std::uint32_t>(64 * w + __builtin_ctzll(word)));
+        }
+      }
+      break;
+    case Container::RUN:
+      for (Size r = 0; container.values.size() > r; r += 2) {
+        for (std::uint32_t value = container.values[r], last = value + container.values[r + 1]; last >= value; ++value) {
+          f(value);
+        }
+      }
+      break;
+    }
+  }
+
+  static bool contains(const Container & container, const std::uint16_t value) {
+    switch (container.type) {
+    case Container::ARRAY:
+      return std::binary_search(container.values.begin(), container.values.end(), value);
+    case Container::BITMAP:
+      return 0 != (container.words[value / 64] >> (value % 64) & 1);
+    default: {
+      Size first = 0, count = container.values.size() / 2;
+      while (0 < count) {
+        const Size half = count / 2;
+        if (container.values[2 * (first + half)] <= value) {
+          first += half + 1;
+          count -= half + 1;
+        } else {
+          count = half;
+        }
+      }
+      return 0 < first && value - container.values[2 * (first - 1)] <= container.values[2 * (first - 1) + 1];
+    }
+    }
+  }
+
+  static void insert(Container & container, const std::uint16_t value) {
+    if (Container::RUN == container.type) {
+      if (contains(container, value)) {
+        return;
+      }
+      ARRAY_MAX > container.cardinality ? to_array(container) : to_bitmap(container);
+    }
+    if (Container::BITMAP == container.type) {
+      std::uint64_t & word = container.words[value / 64];
+      container.cardinality += 0 == (word >> (value % 64) & 1);
+      word |= std::uint64_t{1} << (value % 64);
+      return;
+    }
+    auto & values = container.values;
+    if (values.empty() || values.back() < value) {
+      values.push_back(value);
+    } else {
+      const auto i = std::lower_bound(values.begin(), values.end(), value);
+      if (*i == value) {
+        return;
+      }
+      values.insert(i, value);
+    }
+    if (ARRAY_MAX < ++container.cardinality) {
+      to_bitmap(container);
+    }
+  }
+
+  static void to_bitmap(Container & container) {
+    if (Container::BITMAP == container.type) {
+      return;
+    }
+    std::vector<std::uint64_t> words(WORDS);
+    each(container, [&words](const std::uint32_t value) { words[value / 64] |= std::uint64_t{1} << (value % 64); });
+    container.words = std::move(words);
+    container.values = std::vector<std::uint16_t>();
+    container.type = Container::BITMAP;
+  }
+
+  static void to_array(Container & container) {
+    if (Container::ARRAY == container.type) {
+      return;
+    }
+    std::vector<std::uint16_t> values;
+    values.reserve(container.cardinality);
+    each(container, [&values](const std::uint32_t value) { values.push_back(value); });
+    container.values = std::move(values);
+    container.words = std::vector<std::uint64_t>();
+    container.type = Container::ARRAY;
+  }
+
+  static Size count_runs(const Container & container) {
+    switch (container.type) {
+    case Container::ARRAY: {
+      Size runs = container.values.empty() ? 0 : 1;
+      for (Size i = 1; container.values.size() > i; ++i) {
+        runs += container.values[i - 1] + 1 != container.values[i];
+      }
+      return runs;
+    }
+    case Container::BITMAP: {
+      /* a run starts at every set bit whose lower neighbour is clear */
+      Size runs = 0;
+      std::uint64_t carry = 0;
+      for (const std::uint64_t word : container.words) {
+        runs += __builtin_popcountll(word & ~(word << 1 | carry));
+        carry = word >> 63;
+      }
+      return runs;
+    }
+    default:
+      return container.values.size() / 2;
+    }
+  }
+
+  static void to_runs(Container & container, const Size runs) {
+    if (Container::RUN == container.type) {
+      return;
+    }
+    std::vector<std::uint16_t> values;
+    values.reserve(2 * runs);
+    each(container, [&values](const std::uint32_t value) {
+      if ( ! values.empty() && values[values.size() - 2] + values.back() + 1u == value) {
+        ++values.back();
+      } else {
+        values.push_back(value);
+        values.push_back(0);
+      }
+    });
+    container.values = std::move(values);
+    container.words = std::vector<std::uint64_t>();
+    container.type = Container::RUN;
+  }
+
+  /* the words of a container, converted into scratch unless it is a bitmap */
+  static const std::uint64_t * words(const Container & container, Container & scratch) {
+    if (Container::BITMAP == container.type) {
+      return container.words.data();
+    }
+    scratch = container;
+    to_bitmap(scratch);
+    return scratch.words.data();
+  }
+
+  /* arrays over ARRAY_MAX become bitmaps, bitmaps up to it arrays */
+  static void settle(Container & container) {
+    if (Container::ARRAY == container.type) {
+      container.cardinality = container.values.size();
+      if (ARRAY_MAX < container.cardinality) {
+        to_bitmap(container);
+      }
+    } else {
+      Size cardinality = 0;
+      for (const std::uint64_t word : container.words) {
+        cardinality += __builtin_popcountll(word);
+      }
+      container.cardinality = cardinality;
+      if (ARRAY_MAX >= cardinality) {
+        to_array(container);
+      }
+    }
+  }
+
+  static Container combine(const Container & x, const Container & y, const Operation operation) {
+    Container result;
+    if (Container::ARRAY == x.type && Container::ARRAY == y.type) {
+      const auto & a = x.values, & b = y.values;
+      auto output = std::back_inserter(result.values);
+      switch (operation) {
+      case AND: std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), output); break;
+      case OR: std::set_union(a.begin(), a.end(), b.begin(), b.end(), output); break;
+      case XOR: std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), output); break;
+      case ANDNOT: std::set_difference(a.begin(), a.end(), b.begin(), b.end(), output); break;
+      }
+      settle(result);
+      return result;
+    }
+    /* the result is a subset of an array, look its values up in the other side */
+    const Container * array = nullptr, * other = nullptr;
+    if (Container::ARRAY == x.type && (AND == operation || ANDNOT == operation)) {
+      array = &x;
+      other = &y;
+    } else if (Container::ARRAY == y.type && AND == operation) {
+      array = &y;
+      other = &x;
+    }
+    if (nullptr != array) {
+      const bool keep = AND == operation;
+      for (const std::uint16_t value : array->values) {
+        if (keep == contains(*other, value)) {
+          result.values.push_back(value);
+        }
+      }
+      settle(result);
+      return result;
+    }
+    Container x_scratch, y_scratch;
+    const std::uint64_t * a = words(x, x_scratch), * b = words(y, y_scratch);
+    result.type = Container::BITMAP;
+    result.words.resize(WORDS);
+    std::uint64_t * output = result.words.data();
+    switch (operation) {
+    case AND: for (Size i = 0; WORDS > i; ++i) { output[i] = a[i] & b[i]; } break;
+    case OR: for (Size i = 0; WORDS > i; ++i) { output[i] = a[i] | b[i]; } break;
+    case XOR: for (Size i = 0; WORDS > i; ++i) { output[i] = a[i] ^ b[i]; } break;
+    case ANDNOT: for (Size i = 0; WORDS > i; ++i) { output[i] = a[i] & ~b[i]; } break;
+    }
+    settle(result);
+    return result;
+  }
+
+  static Bitmap combine(const Bitmap & x, const Bitmap & y, const Operation operation) {
+    Bitmap result;
+    const bool keep_x = AND != operation, keep_y = OR == operation || XOR == operation;
+    const auto add = [&result](const Id key, Container container) {
+      if (0 < container.cardinality) {
+        result.keys_.push_back(key);
+        result.containers_.push_back(std::move(container));
+      }
+    };
+    Size i = 0, j = 0;
+    while (x.keys_.size() > i && y.keys_.size() > j) {
+      if (x.keys_[i] < y.keys_[j]) {
+        if (keep_x) {
+          add(x.keys_[i], x.containers_[i]);
+        }
+        ++i;
+      } else if (y.keys_[j] < x.keys_[i]) {
+        if (keep_y) {
+          add(y.keys_[j], y.containers_[j]);
+        }
+        ++j;
+      } else {
+        add(x.keys_[i], combine(x.containers_[i], y.containers_[j], operation));
+        ++i;
+        ++j;
+      }
+    }
+    for (; keep_x && x.keys_.size() > i; ++i) {
+      add(x.keys_[i], x.containers_[i]);
+    }
+    for (; keep_y && y.keys_.size() > j; ++j) {
+      add(y.keys_[j], y.containers_[j]);
+    }
+    return result;
+  }
+
+  std::vector<Id> keys_;
+  std::vector<Container> containers_;
+};
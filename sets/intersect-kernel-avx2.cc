@@ -0,0 +1,111 @@
+/* built with -mavx2 */
+
+#include <array>
+
+#include <immintrin.h>
+
+#include "intersect-kernel.h"
+#include "intersect-loop.h"
+
+namespace simd {
+namespace avx2 {
+namespace {
+
+/*
+ * every type is shuffled as 8 lanes of 32 bits, a 64 bits id spans two
+ * lanes. E is how many lanes an id takes.
+ */
+template<std::size_t E>
+struct Lanes {
+  static constexpr std::size_t W = 8 / E;
+  using Array = std::array<int, 8>;
+  using Table = std::array<Array, 1 << W>;
+
+  /* the ids rotated by r */
+  static constexpr Array rotation(const std::size_t r) {
+    Array lanes{};
+    for (std::size_t i = 0; 8 > i; ++i) {
+      lanes[i] = static_cast<int>(((i / E + r) % W) * E + i % E);
+    }
+    return lanes;
+  }
+
+  /* the ids set in a mask first */
+  static constexpr Table table() {
+    Table table{};
+    for (std::size_t mask = 0; (1u << W) > mask; ++mask) {
+      std::size_t out = 0;
+      for (std::size_t id = 0; W > id; ++id) {
+        if (0 != (mask & (1u << id))) {
+          for (std::size_t lane = 0; E > lane; ++lane) {
+            table[mask][out++] = static_cast<int>(id * E + lane);
+          }
+        }
+      }
+    }
+    return table;
+  }
+
+  static constexpr Table TABLE = table();
+
+  static __m256i vector(const Array & l) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(l.data()));
+  }
+
+  template<std::size_t R>
+  static __m256i rotate(const __m256i x) {
+    static constexpr Array index = rotation(R);
+    return _mm256_permutevar8x32_epi32(x, vector(index));
+  }
+
+  template<typename T>
+  static void pack(T * output, const __m256i x, const unsigned mask) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), _mm256_permutevar8x32_epi32(x, vector(TABLE[mask])));
+  }
+};
+
+template<typename TYPE>
+struct Common : Lanes<sizeof(TYPE) / 4> {
+  using T = TYPE;
+  using R = __m256i;
+  static R load(const T * p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+};
+
+struct UInt32 : Common<std::uint32_t> {
+  static unsigned matches(const R a, const R b) {
+    R equal = _mm256_cmpeq_epi32(a, b);
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<1>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<2>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<3>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<4>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<5>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<6>(b)));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(a, rotate<7>(b)));
+    return _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+  }
+};
+
+struct UInt64 : Common<std::uint64_t> {
+  static unsigned matches(const R a, const R b) {
+    R equal = _mm256_cmpeq_epi64(a, b);
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1))));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(1, 0, 3, 2))));
+    equal = _mm256_or_si256(equal, _mm256_cmpeq_epi64(a, _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3))));
+    return _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+  }
+};
+
+} // namespace
+
+std::size_t intersect(const std::uint32_t * a, const std::size_t a_size, const std::uint32_t * b, const std::size_t b_size,
+    std::uint32_t * output, std::size_t & a_used, std::size_t & b_used) {
+  return loop::intersect<UInt32>(a, a_size, b, b_size, output, a_used, b_used);
+}
+
+std::size_t intersect(const std::uint64_t * a, const std::size_t a_size, const std::uint64_t * b, const std::size_t b_size,
+    std::uint64_t * output, std::size_t & a_used, std::size_t & b_used) {
+  return loop::intersect<UInt64>(a, a_size, b, b_size, output, a_used, b_used);
+}
+
+} // namespace avx2
+} // namespace simd
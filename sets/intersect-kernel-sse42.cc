@@ -0,0 +1,85 @@
+/* built with -msse4.2 */
+
+#include <array>
+
+#include <nmmintrin.h>
+
+#include "intersect-kernel.h"
+#include "intersect-loop.h"
+
+namespace simd {
+namespace sse42 {
+namespace {
+
+/* byte shuffles packing the lanes set in a mask first, E bytes a lane */
+template<std::size_t E>
+struct Pack {
+  static constexpr std::size_t W = 16 / E;
+  using Table = std::array<std::array<char, 16>, 1 << W>;
+
+  static constexpr Table table() {
+    Table table{};
+    for (std::size_t mask = 0; (1u << W) > mask; ++mask) {
+      std::size_t out = 0;
+      for (std::size_t lane = 0; W > lane; ++lane) {
+        if (0 != (mask & (1u << lane))) {
+          for (std::size_t byte = 0; E > byte; ++byte) {
+            table[mask][out++] = static_cast<char>(lane * E + byte);
+          }
+        }
+      }
+      for (; 16 > out; ++out) {
+        table[mask][out] = static_cast<char>(0x80);
+      }
+    }
+    return table;
+  }
+
+  static constexpr Table TABLE = table();
+
+  template<typename T>
+  static void pack(T * output, const __m128i x, const unsigned mask) {
+    const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(TABLE[mask].data()));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_shuffle_epi8(x, shuffle));
+  }
+};
+
+template<typename TYPE>
+struct Common : Pack<sizeof(TYPE)> {
+  using T = TYPE;
+  using R = __m128i;
+  static R load(const T * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+};
+
+struct UInt32 : Common<std::uint32_t> {
+  static unsigned matches(const R a, const R b) {
+    R equal = _mm_cmpeq_epi32(a, b);
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1))));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3))));
+    return _mm_movemask_ps(_mm_castsi128_ps(equal));
+  }
+};
+
+struct UInt64 : Common<std::uint64_t> {
+  static unsigned matches(const R a, const R b) {
+    R equal = _mm_cmpeq_epi64(a, b);
+    equal = _mm_or_si128(equal, _mm_cmpeq_epi64(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))));
+    return _mm_movemask_pd(_mm_castsi128_pd(equal));
+  }
+};
+
+} // namespace
+
+std::size_t intersect(const std::uint32_t * a, const std::size_t a_size, const std::uint32_t * b, const std::size_t b_size,
+    std::uint32_t * output, std::size_t & a_used, std::size_t & b_used) {
+  return loop::intersect<UInt32>(a, a_size, b, b_size, output, a_used, b_used);
+}
+
+std::size_t intersect(const std::uint64_t * a, const std::size_t a_size, const std::uint64_t * b, const std::size_t b_size,
+    std::uint64_t * output, std::size_t & a_used, std::size_t & b_used) {
+  return loop::intersect<UInt64>(a, a_size, b, b_size, output, a_used, b_used);
+}
+
+} // namespace sse42
+} // namespace simd
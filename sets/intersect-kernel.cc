@@ -0,0 +1,70 @@
+#include "intersect-kernel.h"
+
+namespace simd {
+
+#define DECLARE_INTERSECT(T) \
+  std::size_t intersect(const T * a, std::size_t a_size, const T * b, std::size_t b_size, \
+      T * output, std::size_t & a_used, std::size_t & b_used);
+
+namespace sse42 {
+DECLARE_INTERSECT(std::uint32_t)
+DECLARE_INTERSECT(std::uint64_t)
+} // namespace sse42
+
+namespace avx2 {
+DECLARE_INTERSECT(std::uint32_t)
+DECLARE_INTERSECT(std::uint64_t)
+} // namespace avx2
+
+#undef DECLARE_INTERSECT
+
+Kernel detect() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return Kernel::AVX2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return Kernel::SSE42;
+  }
+  return Kernel::SCALAR;
+}
+
+namespace {
+Kernel current = detect();
+} // namespace
+
+Kernel kernel() {
+  return current;
+}
+
+/* for benchmarks, asking for more than detect() falls back to it */
+void kernel(const Kernel k) {
+  current = static_cast<int>(k) <= static_cast<int>(detect()) ? k : detect();
+}
+
+const char * name(const Kernel k) {
+  switch (k) {
+  case Kernel::AVX2: return "avx2";
+  case Kernel::SSE42: return "sse4.2";
+  default: return "scalar";
+  }
+}
+
+#define DEFINE_INTERSECT(T) \
+  std::size_t intersect(const T * a, const std::size_t a_size, const T * b, const std::size_t b_size, \
+      T * output, std::size_t & a_used, std::size_t & b_used) { \
+    switch (current) { \
+    case Kernel::AVX2: return avx2::intersect(a, a_size, b, b_size, output, a_used, b_used); \
+    case Kernel::SSE42: return sse42::intersect(a, a_size, b, b_size, output, a_used, b_used); \
+    default: \
+      a_used = b_used = 0; \
+      return 0; \
+    } \
+  }
+
+DEFINE_INTERSECT(std::uint32_t)
+DEFINE_INTERSECT(std::uint64_t)
+
+#undef DEFINE_INTERSECT
+
+} // namespace simd
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * SIMD Intersection Kernels
+ * -------------------------
+ * intersect two sorted arrays of distinct unsigned ids a block at a time:
+ * a block of a is compared for equality against every rotation of a
+ * block of b, the lanes of a that matched are packed to the front by a
+ * shuffle looked up from the match mask and stored, and whichever block
+ * ends with the smaller id moves on. the kernel is picked once from
+ * CPUID: AVX2, SSE4.2 or none.
+ *
+ * intersect returns how many ids it wrote to output, which needs room
+ * for the smaller input plus SLACK, as whole blocks are stored. it stops
+ * where a block no longer fits: a_used and b_used tell the caller where
+ * to continue with its scalar loop.
+ */
+namespace simd {
+
+enum class Kernel { SCALAR, SSE42, AVX2 };
+
+constexpr std::size_t SLACK = 8;
+
+/* the best kernel this CPU supports */
+Kernel detect();
+
+/* the kernel in use, defaults to detect() */
+Kernel kernel();
+void kernel(Kernel);
+
+const char * name(Kernel);
+
+std::size_t intersect(const std::uint32_t * a, std::size_t a_size, const std::uint32_t * b, std::size_t b_size,
+    std::uint32_t * output, std::size_t & a_used, std::size_t & b_used);
+std::size_t intersect(const std::uint64_t * a, std::size_t a_size, const std::uint64_t * b, std::size_t b_size,
+    std::uint64_t * output, std::size_t & a_used, std::size_t & b_used);
+
+template<typename T>
+struct Intersectable : std::integral_constant<bool,
+  std::is_same<T, std::uint32_t>::value || std::is_same<T, std::uint64_t>::value> { };
+
+} // namespace simd
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * the block loop shared by the kernels, V is one instruction set for one
+ * type: W ids per block, matches(a, b) is the mask of the lanes of a
+ * equal to some lane of b and pack(output, a, mask) stores those lanes
+ * of a first.
+ *
+ * ids are distinct, so every id of the block ending with the smaller id
+ * has been compared against all ids of the other input it could equal,
+ * and advancing both on a tie skips nothing.
+ */
+namespace simd {
+namespace loop {
+
+template<class V>
+std::size_t intersect(const typename V::T * a, const std::size_t a_size, const typename V::T * b, const std::size_t b_size,
+    typename V::T * output, std::size_t & a_used, std::size_t & b_used) {
+  using T = typename V::T;
+  constexpr std::size_t W = V::W;
+  std::size_t i = 0, j = 0, count = 0;
+  while (a_size >= i + W && b_size >= j + W) {
+    const auto x = V::load(a + i), y = V::load(b + j);
+    const unsigned mask = V::matches(x, y);
+    V::pack(output + count, x, mask);
+    count += __builtin_popcount(mask);
+    const T a_last = a[i + W - 1], b_last = b[j + W - 1];
+    i += (a_last <= b_last) * W;
+    j += (b_last <= a_last) * W;
+  }
+  a_used = i;
+  b_used = j;
+  return count;
+}
+
+} // namespace loop
+} // namespace simd
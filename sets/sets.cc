@@ -1,116 +1,298 @@
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
+#include <random>
+#include <string>
 #include <vector>
 
 #include <cassert>
 
+#include "bitmap.h"
+#include "sets.h"
+
+std::ostream & operator << (std::ostream & o, const Set<std::size_t> & set) {
+  for (const int item : set.elements()) {
+    o << item << ", ";
+  }
+  return o;
+}
+
+/* size distinct sorted ids out of [0, range) */
 template<typename T>
-class Set {
-  using Self = Set<T>;
-  using Size = std::size_t;
-  using Vector = std::vector<T>;
-
-  bool is_sorted_ = true;
-  Vector vector_{};
-public:
-  template<typename ... ARGS>
-  Self & push(ARGS && ... args) {
-    vector_.emplace_back(std::forward<ARGS>(args)...);
-    const Size size = vector_.size();
-    if (1 < size && is_sorted_) {
-      is_sorted_ = vector_[size - 2] <= vector_[size - 1];
-    }
-    return *this;
+std::vector<T> posting_list(std::mt19937_64 & generator, const std::size_t size, const T range) {
+  std::vector<T> ids(size);
+  for (auto & id : ids) {
+    id = generator() % range;
   }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  return ids;
+}
 
-  /* Unfortunately `union` is a reserved word in c++ */
-  Self Union(const Self & other) {
-    Self result;
-    if ( ! is_sorted_) {
-      std::sort(vector_.begin(), vector_.end());
-      is_sorted_ = true;
-    }
-    Vector copy;
-    if ( ! other.is_sorted_) {
-      std::copy(other.vector_.begin(), other.vector_.end(), std::back_inserter(copy));
-      std::sort(copy.begin(), copy.end());
-    }
-    const Vector & o = other.is_sorted_ ? other.vector_ : copy;
-    for (Size i = 0, j = 0; vector_.size() > i && o.size() > j;) {
-      if (vector_[i] < o[j]) {
-        ++i;
-      } else if (vector_[i] > o[j]) {
-        ++j;
-      } else {
-        result.vector_.push_back(vector_[i]);
-        ++i;
-        ++j;
+template<typename F>
+double time(F && f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * intersects two posting lists of size ids from [0, 4 size), about a
+ * quarter of each in common, with every kernel and std::set_intersection,
+ * then a list size / 1000 long with a list of size.
+ */
+template<typename T>
+void benchmark(const std::size_t size, const char * type) {
+  std::mt19937_64 generator(size);
+  const std::vector<T> a = posting_list<T>(generator, size, 4 * size);
+  const std::vector<T> b = posting_list<T>(generator, size, 4 * size);
+  const std::vector<T> small = posting_list<T>(generator, size / 1000, 4 * size);
+  std::cout << type << std::endl;
+
+  for (const auto & [x, y] : {std::make_pair(&a, &b), std::make_pair(&small, &b)}) {
+    std::cout << "  " << x->size() << " ∩ " << y->size() << std::endl;
+    std::vector<T> expected;
+    const double standard = time([&]() {
+      std::set_intersection(x->begin(), x->end(), y->begin(), y->end(), std::back_inserter(expected));
+    });
+    std::cout << "    std::set_intersection: " << standard << "s" << std::endl;
+    for (const simd::Kernel kernel : {simd::Kernel::SCALAR, simd::Kernel::SSE42, simd::Kernel::AVX2}) {
+      simd::kernel(kernel);
+      if (kernel != simd::kernel()) {
+        continue;
       }
+      Set<T> set_x(*x), set_y(*y), result;
+      set_x.size();
+      set_y.size();
+      const double seconds = time([&]() { set_x.intersection(set_y, result); });
+      assert(std::equal(expected.begin(), expected.end(), result.elements().begin(), result.elements().end()));
+      std::cout << "    " << simd::name(kernel) << ": " << seconds << "s" << std::endl;
     }
-    result.is_sorted_ = true;
-    return result;
+    simd::kernel(simd::detect());
   }
+}
 
-  Self intersection(const Self & other) {
-    Self result;
-    if ( ! is_sorted_) {
-      std::sort(vector_.begin(), vector_.end());
-      is_sorted_ = true;
+/*
+ * set algebra on vectors against compressed bitmaps, for size ids at
+ * half density and for size ids in runs of 1000.
+ */
+void bitmap_benchmark(const std::size_t size) {
+  using Id = Bitmap::Id;
+  std::mt19937_64 generator(size);
+  std::vector<Id> runs;
+  for (Id start = 0; size > runs.size(); start += 1000 + generator() % 4000) {
+    for (Id id = start; start + 1000 > id; ++id) {
+      runs.push_back(id);
     }
-    Vector copy;
-    if ( ! other.is_sorted_) {
-      std::copy(other.vector_.begin(), other.vector_.end(), std::back_inserter(copy));
-      std::sort(copy.begin(), copy.end());
+  }
+  const std::pair<const char *, std::vector<Id>> inputs[][2] = {
+    {{"dense", posting_list<Id>(generator, size, 2 * size)}, {"dense", posting_list<Id>(generator, size, 2 * size)}},
+    {{"runs", runs}, {"dense", posting_list<Id>(generator, size, 2 * size)}},
+  };
+  for (const auto & [x, y] : inputs) {
+    std::cout << x.first << " " << x.second.size() << ", " << y.first << " " << y.second.size() << std::endl;
+    Set<Id> set_x(x.second), set_y(y.second);
+    Bitmap bitmap_x(x.second), bitmap_y(y.second);
+    bitmap_x.optimize();
+    bitmap_y.optimize();
+    const auto serialized = bitmap_x.serialize();
+    std::cout << "  bytes: vector " << 8 * x.second.size() << ", bitmap " << bitmap_x.bytes()
+      << ", serialized " << serialized.size() << std::endl;
+
+    const Bitmap::View view(serialized.data(), serialized.size());
+    assert(view.cardinality() == x.second.size());
+    assert(view.bitmap() == bitmap_x);
+    for (std::size_t i = 0; 1000 > i; ++i) {
+      const Id id = generator() % (2 * size);
+      assert(view.contains(id) == std::binary_search(x.second.begin(), x.second.end(), id));
     }
-    const Vector & o = other.is_sorted_ ? other.vector_ : copy;
-    Size i = 0, j = 0;
-    while (vector_.size() > i && o.size() > j) {
-      if (vector_[i] < o[j]) {
-        result.vector_.push_back(vector_[i]);
-        ++i;
-      } else if (vector_[i] > o[j]) {
-        result.vector_.push_back(o[j]);
-        ++j;
-      } else {
-        ++i;
-        ++j;
-      }
+
+    /*
+     * corrupt copies of the last descriptor (key at 0, offset at 8, type,
+     * cardinality and size at 16, 20 and 24) must be refused, not read
+     * out of bounds.
+     */
+    const std::size_t count = serialized.size() < 24 ? 0 : *reinterpret_cast<const std::uint64_t *>(serialized.data() + 8);
+    if (0 < count) {
+      const std::size_t last = 24 + 32 * (count - 1);
+      const std::uint64_t payload = *reinterpret_cast<const std::uint64_t *>(serialized.data() + last + 8);
+      const auto refused = [&](std::initializer_list<std::pair<std::size_t, std::uint32_t>> fields, const std::size_t length) {
+        std::vector<char> corrupt(serialized.begin(), serialized.begin() + length);
+        for (const auto & [field, value] : fields) {
+          std::memcpy(corrupt.data() + last + field, &value, sizeof(value));
+        }
+        try {
+          Bitmap::View(corrupt.data(), corrupt.size());
+        } catch (const std::runtime_error &) {
+          return true;
+        }
+        return false;
+      };
+      assert(refused({{16, 1}, {24, 1}}, payload + 8));
+      assert(refused({{16, 2}, {20, 1}, {24, 1}}, serialized.size()));
+      assert(refused({{16, 0}, {20, 4097}, {24, 4097}}, serialized.size()));
+      assert(refused({{20, (1 << 16) + 1}}, serialized.size()));
+      assert(1 == count || refused({{0, 0}, {4, 0}}, serialized.size()));
     }
-    for (; vector_.size() > i; ++i) {
-      result.vector_.push_back(vector_[i]);
+
+    const auto run = [&](const char * name, auto && vector, auto && bitmap) {
+      Set<Id> expected;
+      Bitmap result;
+      const double vector_seconds = time([&]() { expected = vector(); });
+      const double bitmap_seconds = time([&]() { result = bitmap(); });
+      const std::vector<Id> ids = result.vector();
+      assert(std::equal(ids.begin(), ids.end(), expected.elements().begin(), expected.elements().end()));
+      std::cout << "  " << name << ": vector " << vector_seconds << "s, bitmap " << bitmap_seconds << "s" << std::endl;
+    };
+    run("AND", [&]() { return set_x.intersection(set_y); }, [&]() { return bitmap_x & bitmap_y; });
+    run("OR", [&]() { return set_x.Union(set_y); }, [&]() { return bitmap_x | bitmap_y; });
+    run("XOR", [&]() { return set_x.symmetric_difference(set_y); }, [&]() { return bitmap_x ^ bitmap_y; });
+    run("ANDNOT", [&]() { return set_x.difference(set_y); }, [&]() { return bitmap_x.andnot(bitmap_y); });
+    const double seconds = time([&]() { assert(bitmap_x.cardinality() == x.second.size()); });
+    std::cout << "  cardinality: " << seconds << "s" << std::endl;
+  }
+}
+
+/*
+ * rounds of the four operations on two sets of size unsorted ids with
+ * duplicates, after the first query has sorted them, returning new sets
+ * against writing into the same results every round.
+ */
+void algebra_benchmark(const std::size_t size, const std::size_t rounds) {
+  using Id = std::uint64_t;
+  std::mt19937_64 generator(size);
+  Set<Id> x, y;
+  for (std::size_t i = 0; size > i; ++i) {
+    x.push(generator() % (2 * size));
+    y.push(generator() % (2 * size));
+  }
+  std::cout << "first query: " << time([&]() { x.size(); y.size(); }) << "s, "
+    << x.size() << " and " << y.size() << " distinct" << std::endl;
+
+  Set<Id> results[4];
+  const double reused = time([&]() {
+    for (std::size_t round = 0; rounds > round; ++round) {
+      x.Union(y, results[0]);
+      x.intersection(y, results[1]);
+      x.difference(y, results[2]);
+      x.symmetric_difference(y, results[3]);
     }
-    for (; o.size() > j; ++j) {
-      result.vector_.push_back(o[j]);
+  });
+  std::size_t total = 0;
+  const double returned = time([&]() {
+    for (std::size_t round = 0; rounds > round; ++round) {
+      total += x.Union(y).size() + x.intersection(y).size() + x.difference(y).size() + x.symmetric_difference(y).size();
     }
-    result.is_sorted_ = true;
-    return result;
-  }
+  });
+  assert(rounds * (results[0].size() + results[1].size() + results[2].size() + results[3].size()) == total);
+  std::cout << "round, new results: " << returned / rounds << "s" << std::endl
+    << "round, reused results: " << reused / rounds << "s" << std::endl;
+}
 
-  friend std::ostream & operator << (std::ostream &, const Set<T> &);
-};
+/*
+ * k posting lists, the i-th of size / (i + 1) ids out of [0, 2 size)
+ * and size / 100 ids common to all, united and intersected pairwise,
+ * all at once and all at once on a TaskPool.
+ */
+void multiway_benchmark(const std::size_t size, const std::size_t k, const std::size_t threads) {
+  using Id = std::uint64_t;
+  std::mt19937_64 generator(size);
+  std::vector<Set<Id>> sets;
+  Set<Id>::Sets pointers;
+  std::size_t total = 0;
+  const std::vector<Id> common = posting_list<Id>(generator, size / 100, 2 * size);
+  for (std::size_t i = 0; k > i; ++i) {
+    std::vector<Id> ids = posting_list<Id>(generator, size / (i + 1), 2 * size);
+    ids.insert(ids.end(), common.begin(), common.end());
+    sets.emplace_back(std::move(ids));
+    total += sets.back().size();
+  }
+  for (const auto & set : sets) {
+    pointers.push_back(&set);
+  }
+  std::cout << k << " sets, " << total << " ids" << std::endl;
 
-std::ostream & operator << (std::ostream & o, const Set<std::size_t> & set) {
-  for (const int item : set.vector_) {
-    o << item << ", ";
+  TaskPool pool(threads);
+  for (const bool unite : {true, false}) {
+    Set<Id> pairwise, result, parallel;
+    const double pairwise_seconds = time([&]() {
+      pairwise = sets[0];
+      for (std::size_t i = 1; k > i; ++i) {
+        pairwise = unite ? pairwise.Union(sets[i]) : pairwise.intersection(sets[i]);
+      }
+    });
+    const double all_seconds = time([&]() {
+      unite ? Set<Id>::union_all(pointers, result) : Set<Id>::intersect_all(pointers, result);
+    });
+    const double parallel_seconds = time([&]() {
+      unite ? Set<Id>::union_all(pool, pointers, parallel) : Set<Id>::intersect_all(pool, pointers, parallel);
+    });
+    assert(pairwise.elements() == result.elements() && pairwise.elements() == parallel.elements());
+    std::cout << (unite ? "  union" : "  intersection") << ", " << result.size() << " ids" << std::endl
+      << "    pairwise: " << pairwise_seconds << "s" << std::endl
+      << "    all: " << all_seconds << "s" << std::endl
+      << "    all, " << threads << " threads: " << parallel_seconds << "s" << std::endl;
   }
-  return o;
+
+  /* an empty input empties an intersection and leaves a union as it is */
+  const Set<Id> empty;
+  Set<Id> serial, parallel;
+  pointers.push_back(&empty);
+  Set<Id>::intersect_all(pointers, serial);
+  Set<Id>::intersect_all(pool, pointers, parallel);
+  assert(0 == serial.size() && 0 == parallel.size());
+  Set<Id>::union_all(pointers, serial);
+  Set<Id>::union_all(pool, pointers, parallel);
+  assert(serial.elements() == parallel.elements());
 }
 
-int main() {
+int main(int argc, char * * argv) {
+  if (2 < argc && std::string("benchmark") == argv[1]) {
+    const std::size_t size = std::stoul(argv[2]);
+    benchmark<std::uint32_t>(size, "uint32");
+    benchmark<std::uint64_t>(size, "uint64");
+    return 0;
+  }
+  if (2 < argc && std::string("algebra-benchmark") == argv[1]) {
+    algebra_benchmark(std::stoul(argv[2]), 3 < argc ? std::stoul(argv[3]) : 10);
+    return 0;
+  }
+  if (2 < argc && std::string("multiway-benchmark") == argv[1]) {
+    multiway_benchmark(std::stoul(argv[2]), 3 < argc ? std::stoul(argv[3]) : 64,
+        4 < argc ? std::stoul(argv[4]) : std::thread::hardware_concurrency());
+    return 0;
+  }
+  if (2 < argc && std::string("bitmap-benchmark") == argv[1]) {
+    bitmap_benchmark(std::stoul(argv[2]));
+    return 0;
+  }
+
   using MySet = Set<std::size_t>;
   MySet set_a, set_b;
   std::cout << "set A is " << set_a.push(1).push(2).push(3).push(5).push(4) << std::endl;
   std::cout << "set B is " << set_b.push(2).push(4).push(6) << std::endl;
 
-
   {
     MySet union_set = set_a.Union(set_b);
-    std::cout << "A U B is " << union_set << std::endl;
+    std::cout << "A ∪ B is " << union_set << std::endl;
+  }
+
+  {
+    MySet intersection_set = set_a.intersection(set_b);
+    std::cout << "A ∩ B is " << intersection_set << std::endl;
+  }
+
+  {
+    MySet difference_set = set_a.difference(set_b);
+    std::cout << "A - B is " << difference_set << std::endl;
   }
 
   {
-    MySet union_set = set_a.intersection(set_b);
-    std::cout << "A ∩ B is " << union_set << std::endl;
+    MySet symmetric_difference_set = set_a.symmetric_difference(set_b);
+    std::cout << "A △ B is " << symmetric_difference_set << std::endl;
   }
   return 0;
 }
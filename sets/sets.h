@@ -0,0 +1,454 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+
+#include "../mergesort/task-pool.h"
+#include "../quicksort/quicksort.h"
+#include "intersect-kernel.h"
+
+/*
+ * set kept as a vector. pushing appends and only notes whether the
+ * vector is still strictly increasing, the first query after that sorts
+ * it in place with Pdqsort and drops duplicates, and it stays that way
+ * until the next push out of order. queries are const, the order is not
+ * part of the value, but a set that may still need sorting must not be
+ * read from several threads at once.
+ *
+ * the operations walk both sorted vectors at once without data
+ * dependent branches, except intersection: ids go through the SIMD
+ * kernels and an input GALLOP times smaller than the other is looked up
+ * in it by exponential search, which is O(m log n) instead of O(m + n).
+ * each operation can write into a result the caller keeps around, whose
+ * vector grows to an upper bound of the outcome, not its exact size, once
+ * and is then reused. it default-initializes, so growing it does not
+ * zero the room the kernels overwrite anyway.
+ *
+ * union_all and intersect_all take any number of sets at once, without
+ * intermediate results. on a TaskPool the value range is cut at
+ * quantiles of one input into PARTS per thread, every part is solved
+ * into its own stretch of the result and the stretches are moved
+ * together.
+ */
+/* allocator whose construct() without arguments leaves trivial types uninitialized */
+template<typename T>
+struct DefaultInit : std::allocator<T> {
+  template<typename U>
+  struct rebind { using other = DefaultInit<U>; };
+
+  DefaultInit() = default;
+
+  template<typename U>
+  DefaultInit(const DefaultInit<U> &) noexcept { }
+
+  template<typename U>
+  void construct(U * const pointer) noexcept(std::is_nothrow_default_constructible<U>::value) {
+    ::new (static_cast<void *>(pointer)) U;
+  }
+
+  template<typename U, typename ... ARGS>
+  void construct(U * const pointer, ARGS && ... args) {
+    ::new (static_cast<void *>(pointer)) U(std::forward<ARGS>(args)...);
+  }
+};
+
+template<typename T>
+class Set {
+  using Self = Set<T>;
+  using Size = std::size_t;
+
+public:
+  using Vector = std::vector<T, DefaultInit<T>>;
+
+private:
+  mutable bool is_normal_ = true;
+  mutable Vector vector_{};
+public:
+  static constexpr Size GALLOP = 32;
+  static constexpr Size PARTS = 4;
+  static constexpr Size PARALLEL = 1 << 16;
+
+  using Sets = std::vector<const Self *>;
+
+  Set() = default;
+
+  explicit Set(Vector vector) :
+    is_normal_(std::is_sorted(vector.begin(), vector.end(), std::less_equal<T>())), vector_(std::move(vector)) { }
+
+  explicit Set(const std::vector<T> & vector) : Set(Vector(vector.begin(), vector.end())) { }
+
+  template<typename ... ARGS>
+  Self & push(ARGS && ... args) {
+    vector_.emplace_back(std::forward<ARGS>(args)...);
+    const Size size = vector_.size();
+    if (1 < size && is_normal_) {
+      is_normal_ = vector_[size - 2] < vector_[size - 1];
+    }
+    return *this;
+  }
+
+  Size size() const { return elements().size(); }
+
+  /* sorted and distinct */
+  const Vector & elements() const {
+    normalize();
+    return vector_;
+  }
+
+  /* Unfortunately `union` is a reserved word in c++ */
+  void Union(const Self & other, Self & result) const {
+    apply(other, result, size() + other.size(), merge<UNION>);
+  }
+
+  void intersection(const Self & other, Self & result) const {
+    apply(other, result, std::min(size(), other.size()) + simd::SLACK, intersect);
+  }
+
+  /* the elements of this set not in other */
+  void difference(const Self & other, Self & result) const {
+    apply(other, result, size(), subtract);
+  }
+
+  void symmetric_difference(const Self & other, Self & result) const {
+    apply(other, result, size() + other.size(), merge<SYMMETRIC_DIFFERENCE>);
+  }
+
+  Self Union(const Self & other) const { Self result; Union(other, result); return result; }
+  Self intersection(const Self & other) const { Self result; intersection(other, result); return result; }
+  Self difference(const Self & other) const { Self result; difference(other, result); return result; }
+  Self symmetric_difference(const Self & other) const { Self result; symmetric_difference(other, result); return result; }
+
+  /* a k-way merge through a loser tree, duplicates written once */
+  static void union_all(const Sets & sets, Self & result) {
+    all<UNION>(sets, result);
+  }
+
+  /*
+   * the two smallest sets are intersected, then what is left is filtered
+   * through the others by size, merging or, against a set GALLOP times
+   * larger, skipping ahead by exponential search. no sets intersect to
+   * the empty set.
+   */
+  static void intersect_all(const Sets & sets, Self & result) {
+    all<INTERSECTION>(sets, result);
+  }
+
+  static void union_all(TaskPool & pool, const Sets & sets, Self & result) {
+    all<UNION>(pool, sets, result);
+  }
+
+  static void intersect_all(TaskPool & pool, const Sets & sets, Self & result) {
+    all<INTERSECTION>(pool, sets, result);
+  }
+
+  friend std::ostream & operator << (std::ostream &, const Set<T> &);
+
+private:
+  enum Operation { UNION, INTERSECTION, SYMMETRIC_DIFFERENCE };
+
+  struct Range {
+    const T * first, * last;
+    Size size() const { return last - first; }
+  };
+  using Ranges = std::vector<Range>;
+
+  /* at most what OPERATION over ranges can write */
+  template<Operation OPERATION>
+  static Size capacity(const Ranges & ranges) {
+    if (UNION == OPERATION) {
+      Size capacity = 0;
+      for (const auto & range : ranges) {
+        capacity += range.size();
+      }
+      return capacity;
+    }
+    Size capacity = std::numeric_limits<Size>::max();
+    for (const auto & range : ranges) {
+      capacity = std::min(capacity, range.size());
+    }
+    return ranges.empty() ? 0 : capacity + simd::SLACK;
+  }
+
+  static Ranges ranges(const Sets & sets, const Self & result) {
+    Ranges ranges;
+    for (const Self * set : sets) {
+      assert(set != &result);
+      const Vector & elements = set->elements();
+      ranges.push_back(Range{elements.data(), elements.data() + elements.size()});
+    }
+    return ranges;
+  }
+
+  template<Operation OPERATION>
+  static Size all(const Ranges & ranges, T * const output) {
+    return UNION == OPERATION ? unite(ranges, output) : intersect_all(ranges, output);
+  }
+
+  template<Operation OPERATION>
+  static void all(const Sets & sets, Self & result) {
+    const Ranges inputs = ranges(sets, result);
+    result.vector_.clear();
+    result.vector_.resize(capacity<OPERATION>(inputs));
+    result.vector_.resize(all<OPERATION>(inputs, result.vector_.data()));
+    result.is_normal_ = true;
+  }
+
+  /*
+   * splitters come from the largest input for a union and the smallest
+   * for an intersection, the parts of every input between two of them
+   * are found by binary search.
+   */
+  template<Operation OPERATION>
+  static void all(TaskPool & pool, const Sets & sets, Self & result) {
+    const Ranges inputs = ranges(sets, result);
+    Size total = 0;
+    for (const auto & range : inputs) {
+      total += range.size();
+    }
+    if (inputs.empty()) {
+      all<OPERATION>(sets, result);
+      return;
+    }
+    const auto by_size = [](const Range & a, const Range & b) { return a.size() < b.size(); };
+    const Range source = UNION == OPERATION
+      ? *std::max_element(inputs.begin(), inputs.end(), by_size)
+      : *std::min_element(inputs.begin(), inputs.end(), by_size);
+    if (INTERSECTION == OPERATION && 0 == source.size()) {
+      result.vector_.clear();
+      result.is_normal_ = true;
+      return;
+    }
+    /* every part needs a splitter of its own */
+    const Size parts = 1 < pool.threads() ? std::min(PARTS * pool.threads(), total / PARALLEL) : 1;
+    if (2 > parts || source.size() < parts) {
+      all<OPERATION>(sets, result);
+      return;
+    }
+
+    std::vector<Ranges> pieces(parts, inputs);
+    for (Size part = 1; parts > part; ++part) {
+      const T & splitter = source.first[part * source.size() / parts];
+      for (Size i = 0; inputs.size() > i; ++i) {
+        pieces[part][i].first = pieces[part - 1][i].last = std::lower_bound(inputs[i].first, inputs[i].last, splitter);
+      }
+    }
+    std::vector<Size> offsets(parts + 1, 0), counts(parts);
+    for (Size part = 0; parts > part; ++part) {
+      offsets[part + 1] = offsets[part] + capacity<OPERATION>(pieces[part]);
+    }
+    result.vector_.clear();
+    result.vector_.resize(offsets[parts]);
+    T * const output = result.vector_.data();
+    TaskPool::Group group;
+    for (Size part = 0; parts > part; ++part) {
+      pool.spawn(group, [&, part]() { counts[part] = all<OPERATION>(pieces[part], output + offsets[part]); });
+    }
+    pool.wait(group);
+    Size count = 0;
+    for (Size part = 0; parts > part; ++part) {
+      std::copy(output + offsets[part], output + offsets[part] + counts[part], output + count);
+      count += counts[part];
+    }
+    result.vector_.resize(count);
+    result.is_normal_ = true;
+  }
+
+  /*
+   * tree[0] is the input holding the smallest element, every other node
+   * keeps the loser of the match played there. leaves are implicit at
+   * k ... 2k - 1 and exhausted inputs lose to everything.
+   */
+  static Size unite(Ranges ranges, T * const output) {
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const Range & range) { return 0 == range.size(); }),
+        ranges.end());
+    const Size k = ranges.size();
+    if (2 >= k) {
+      return 0 == k ? 0 : 1 == k
+        ? std::copy(ranges[0].first, ranges[0].last, output) - output
+        : merge<UNION>(ranges[0].first, ranges[0].size(), ranges[1].first, ranges[1].size(), output);
+    }
+
+    /* the head of every input, copied out so that a match is one comparison */
+    std::vector<T> heads(k);
+    std::vector<unsigned char> done(k, 0);
+    for (Size i = 0; k > i; ++i) {
+      heads[i] = *ranges[i].first;
+    }
+    const auto less = [&heads, &done](const Size a, const Size b) {
+      return (done[a] < done[b]) | ((done[a] == done[b]) & (heads[a] < heads[b]));
+    };
+    constexpr Size NONE = std::numeric_limits<Size>::max();
+    std::vector<Size> tree(k, NONE);
+    for (Size leaf = 0; k > leaf; ++leaf) {
+      Size winner = leaf, node = (leaf + k) / 2;
+      for (; 0 < node && NONE != tree[node]; node /= 2) {
+        if (less(tree[node], winner)) {
+          std::swap(tree[node], winner);
+        }
+      }
+      tree[node] = winner;
+    }
+
+    Size count = 0;
+    while ( ! done[tree[0]]) {
+      Size winner = tree[0];
+      const T item = heads[winner];
+      output[count] = item;
+      count += 0 == count || output[count - 1] != item;
+      if (ranges[winner].last == ++ranges[winner].first) {
+        done[winner] = 1;
+      } else {
+        heads[winner] = *ranges[winner].first;
+      }
+      for (Size node = (winner + k) / 2; 0 < node; node /= 2) {
+        const Size loser = tree[node];
+        const bool swap = less(loser, winner);
+        tree[node] = swap ? winner : loser;
+        winner = swap ? loser : winner;
+      }
+      tree[0] = winner;
+    }
+    return count;
+  }
+
+  static Size intersect_all(Ranges ranges, T * const output) {
+    if (ranges.empty()) {
+      return 0;
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const Range & a, const Range & b) { return a.size() < b.size(); });
+    if (1 == ranges.size()) {
+      return std::copy(ranges[0].first, ranges[0].last, output) - output;
+    }
+    Size count = intersect(ranges[0].first, ranges[0].size(), ranges[1].first, ranges[1].size(), output);
+    for (Size i = 2; ranges.size() > i && 0 < count; ++i) {
+      const T * first = ranges[i].first, * const last = ranges[i].last;
+      Size kept = 0, j = 0;
+      if (ranges[i].size() > GALLOP * count) {
+        for (; count > j && last != first; ++j) {
+          first = gallop(first, last, output[j]);
+          output[kept] = output[j];
+          kept += last != first && output[j] == *first;
+        }
+      } else {
+        while (count > j && last != first) {
+          const T x = output[j], y = *first;
+          output[kept] = x;
+          kept += x == y;
+          j += x <= y;
+          first += y <= x;
+        }
+      }
+      count = kept;
+    }
+    return count;
+  }
+
+  void normalize() const {
+    if ( ! is_normal_) {
+      Pdqsort<T>()(vector_.data(), vector_.size());
+      vector_.erase(std::unique(vector_.begin(), vector_.end()), vector_.end());
+      is_normal_ = true;
+    }
+  }
+
+  /* runs f on both sorted vectors into result, with room for capacity elements, cleared first so growing copies nothing */
+  template<class F>
+  void apply(const Self & other, Self & result, const Size capacity, const F & f) const {
+    assert(&result != this && &result != &other);
+    const Vector & a = elements(), & b = other.elements();
+    result.vector_.clear();
+    result.vector_.resize(capacity);
+    result.vector_.resize(f(a.data(), a.size(), b.data(), b.size(), result.vector_.data()));
+    result.is_normal_ = true;
+  }
+
+  /* the first element of [first, last) not less than item, searched from first */
+  static const T * gallop(const T * first, const T * const last, const T & item) {
+    Size step = 1;
+    const T * low = first;
+    while (last - first > static_cast<std::ptrdiff_t>(step) && first[step] < item) {
+      low = first + step;
+      step *= 2;
+    }
+    return std::lower_bound(low, last - first > static_cast<std::ptrdiff_t>(step) ? first + step + 1 : last, item);
+  }
+
+  /*
+   * both sides advance past the smaller element, or both on a tie. union
+   * writes the smaller element always, symmetric difference only when
+   * the two differ.
+   */
+  template<Operation OPERATION>
+  static Size merge(const T * a, const Size a_size, const T * b, const Size b_size, T * output) {
+    Size i = 0, j = 0, count = 0;
+    while (a_size > i && b_size > j) {
+      const T x = a[i], y = b[j];
+      output[count] = x <= y ? x : y;
+      count += UNION == OPERATION || x != y;
+      i += x <= y;
+      j += y <= x;
+    }
+    output = std::copy(a + i, a + a_size, output + count);
+    std::copy(b + j, b + b_size, output);
+    return count + (a_size - i) + (b_size - j);
+  }
+
+  static Size subtract(const T * a, const Size a_size, const T * b, const Size b_size, T * output) {
+    Size i = 0, j = 0, count = 0;
+    if (b_size > GALLOP * a_size) {
+      for (const T * last = b + b_size; a_size > i; ++i) {
+        b = gallop(b, last, a[i]);
+        if (last == b || a[i] != *b) {
+          output[count++] = a[i];
+        }
+      }
+      return count;
+    }
+    while (a_size > i && b_size > j) {
+      const T x = a[i], y = b[j];
+      output[count] = x;
+      count += x < y;
+      i += x <= y;
+      j += y <= x;
+    }
+    std::copy(a + i, a + a_size, output + count);
+    return count + (a_size - i);
+  }
+
+  static Size intersect(const T * a, Size a_size, const T * b, Size b_size, T * output) {
+    if (a_size > b_size) {
+      std::swap(a, b);
+      std::swap(a_size, b_size);
+    }
+    Size i = 0, j = 0, count = 0;
+    if (b_size > GALLOP * a_size) {
+      for (const T * last = b + b_size; a_size > i && last != b; ++i) {
+        b = gallop(b, last, a[i]);
+        if (last != b && a[i] == *b) {
+          output[count++] = a[i];
+        }
+      }
+      return count;
+    }
+    if constexpr (simd::Intersectable<T>::value) {
+      count = simd::intersect(a, a_size, b, b_size, output, i, j);
+    }
+    while (a_size > i && b_size > j) {
+      const T x = a[i], y = b[j];
+      output[count] = x;
+      count += x == y;
+      i += x <= y;
+      j += y <= x;
+    }
+    return count;
+  }
+};